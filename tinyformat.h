@@ -129,24 +129,111 @@ namespace tfm = tinyformat;
 // general.  If you don't define this, C++11 support is autodetected below.
 // #define TINYFORMAT_USE_VARIADIC_TEMPLATES
 
+// Define to support direct formatting of the socket address types in_addr,
+// in6_addr, sockaddr_in and sockaddr_in6.  Pulls in the system socket headers.
+// #define TINYFORMAT_USE_SOCKADDR
+
+// Define to pad strings according to their display width as UTF-8 text, so
+// that multi-byte, combining and East Asian wide characters line up in
+// columns.  By default the field width counts bytes, as for printf().
+// #define TINYFORMAT_UTF8_DISPLAY_WIDTH
+
+// Define to make truncating string conversions like "%.10s" cut UTF-8 text
+// at a code point boundary, so that a multi-byte character is never split.
+// The precision still gives the maximum number of bytes written.
+// #define TINYFORMAT_UTF8_TRUNCATION
+
+// Define to guarantee that tinyformat never allocates memory, for use in
+// real time code.  Only functions which format into fixed size buffers are
+// available, such as formatToBuffer() and the fixed buffer writers of
+// tinyformat_sinks.h, so a call to an allocating one fails to compile.  The
+// functions formatting onto a std::ostream (format(out, ...), vformat() and
+// the like) allocate if the stream's buffer does, so they are withheld as
+// well unless TINYFORMAT_NO_HEAP_STREAMS is also defined, for programs which
+// only use streams over buffers known not to allocate; printf() and
+// printfln() are never available.  Internal temporary buffers have a fixed
+// size of 256 characters, which limits the length of individual arguments
+// formatted with a truncating precision like "%.10s", with the ' ' flag or
+// centred with formatBraces() "{:^N}", and of join() or halfArray() results
+// with a width or precision; any excess is discarded.  Values in
+// formatKeyValue() and formatJson() records longer than 128 characters are
+// formatted twice, and always quoted.
+// #define TINYFORMAT_NO_HEAP
+// #define TINYFORMAT_NO_HEAP_STREAMS
+
+// Text written for an empty std::optional, a std::variant holding
+// std::monostate and a null smart pointer (except with "%p").
+// #define TINYFORMAT_NONE_TEXT "none"
+
 
 //------------------------------------------------------------------------------
 // Implementation details.
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#ifndef TINYFORMAT_NO_HEAP
+#   include <vector>
+#endif
+
+// The functions which format onto a caller's std::ostream
+#if !defined(TINYFORMAT_NO_HEAP) || defined(TINYFORMAT_NO_HEAP_STREAMS)
+#   define TINYFORMAT_STREAM_API
+#endif
+
+#ifdef TINYFORMAT_USE_SOCKADDR
+#   ifdef _WIN32
+#       include <winsock2.h>
+#       include <ws2tcpip.h>
+#   else
+#       include <netinet/in.h>
+#   endif
+#endif
 
 #ifndef TINYFORMAT_ERROR
 #   define TINYFORMAT_ERROR(reason) assert(0 && reason)
 #endif
 
+// long long is only standard from C++11, but is provided by C++98 compilers
+// as an extension.  Silence the warnings which -pedantic gives for the type.
+// The warning for long long literals can't be silenced, so 64 bit constants
+// are built from their 32 bit halves with TINYFORMAT_U64.
+#if defined(__GNUC__) && __cplusplus < 201103L
+#   define TINYFORMAT_SUPPRESS_LONG_LONG_WARNINGS
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wlong-long"
+#endif
+#define TINYFORMAT_U64(hi, lo) \
+    ((static_cast<unsigned long long>(hi##UL) << 32) | lo##UL)
+
+#ifndef TINYFORMAT_NONE_TEXT
+#   define TINYFORMAT_NONE_TEXT "none"
+#endif
+
 #if !defined(TINYFORMAT_USE_VARIADIC_TEMPLATES) && !defined(TINYFORMAT_NO_VARIADIC_TEMPLATES)
 #   ifdef __GXX_EXPERIMENTAL_CXX0X__
 #       define TINYFORMAT_USE_VARIADIC_TEMPLATES
 #   endif
 #endif
 
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+// C++17 library types which get special treatment
+#   include <string_view>
+#   include <optional>
+#   include <variant>
+#   define TINYFORMAT_HAS_STRING_VIEW
+#   define TINYFORMAT_HAS_OPTIONAL_VARIANT
+#endif
+
+#if __cplusplus >= 201103L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L)
+// C++11 smart pointers
+#   include <memory>
+#   include <type_traits>
+#   include <utility>
+#   define TINYFORMAT_HAS_SMART_POINTERS
+#endif
+
 #if defined(__GLIBCXX__) && __GLIBCXX__ < 20080201
 //  std::showpos is broken on old libstdc++ as provided with OSX.  See
 //  http://gcc.gnu.org/ml/libstdc++/2007-11/msg00075.html
@@ -261,14 +348,330 @@ struct convertToInt<T,true>
     static int invoke(const T& value) { return static_cast<int>(value); }
 };
 
+// Stream buffer which writes into a fixed size character array.  Output past
+// the end of the array is discarded, but counted in the total length.
+class ArrayStreamBuf : public std::streambuf
+{
+    public:
+        ArrayStreamBuf(char* buf, std::streamsize size)
+            : m_discarded(0)
+        {
+            setp(buf, buf + size);
+        }
+
+        // Length of all output, including any which was discarded
+        std::streamsize length() const { return pptr() - pbase() + m_discarded; }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if(!traits_type::eq_int_type(c, traits_type::eof()))
+                ++m_discarded;
+            return traits_type::not_eof(c);
+        }
+
+        virtual std::streamsize xsputn(const char* s, std::streamsize n)
+        {
+            std::streamsize avail = epptr() - pptr();
+            std::streamsize count = n < avail ? n : avail;
+            std::memcpy(pptr(), s, static_cast<size_t>(count));
+            pbump(static_cast<int>(count));
+            m_discarded += n - count;
+            return n;
+        }
+
+    private:
+        std::streamsize m_discarded;
+};
+
+// Stream buffer which collects output in memory.  Output of up to N
+// characters is held in a fixed internal array, so short formatted values
+// can be captured without a heap allocation.  Longer output moves to the
+// heap, or with TINYFORMAT_NO_HEAP is discarded.
+template<int N>
+class SmallStreamBuf : public std::streambuf
+{
+    public:
+        SmallStreamBuf() { setp(m_fixed, m_fixed + N); }
+
+        const char* data() const { return pbase(); }
+        char* data() { return pbase(); }
+        std::streamsize size() const { return pptr() - pbase(); }
+        void clear() { setp(pbase(), epptr()); }
+        // Discard any output after the first n characters
+        void truncate(std::streamsize n)
+        {
+            setp(pbase(), epptr());
+            pbump(static_cast<int>(n));
+        }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if(traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
+#ifdef TINYFORMAT_NO_HEAP
+            return traits_type::eof();
+#else
+            grow(1);
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+            return c;
+#endif
+        }
+
+        virtual std::streamsize xsputn(const char* s, std::streamsize n)
+        {
+            if(epptr() - pptr() < n)
+            {
+#ifdef TINYFORMAT_NO_HEAP
+                n = epptr() - pptr();
+#else
+                grow(n);
+#endif
+            }
+            std::memcpy(pptr(), s, static_cast<size_t>(n));
+            pbump(static_cast<int>(n));
+            return n;
+        }
+
+    private:
+#ifndef TINYFORMAT_NO_HEAP
+        void grow(std::streamsize extra)
+        {
+            std::streamsize used = size();
+            std::streamsize capacity = 2*(epptr() - pbase());
+            if(capacity < used + extra)
+                capacity = used + extra;
+            std::vector<char> larger(static_cast<size_t>(capacity));
+            std::memcpy(&larger[0], pbase(), static_cast<size_t>(used));
+            m_heap.swap(larger);
+            setp(&m_heap[0], &m_heap[0] + capacity);
+            pbump(static_cast<int>(used));
+        }
+
+#endif
+
+        char m_fixed[N];
+#ifndef TINYFORMAT_NO_HEAP
+        std::vector<char> m_heap;
+#endif
+};
+
+// Write len characters of s to the stream, padding to the stream width in the
+// same way as operator<< would for a C string.  columns is the display width
+// of the text, which is used to compute the amount of padding.
+inline void writePadded(std::ostream& out, const char* s, std::streamsize len,
+                        std::streamsize columns)
+{
+    std::streamsize pad = out.width() - columns;
+    out.width(0);
+    if(pad <= 0)
+    {
+        out.write(s, len);
+        return;
+    }
+    bool leftAlign = (out.flags() & std::ios::adjustfield) == std::ios::left;
+    if(leftAlign)
+        out.write(s, len);
+    for(char fill = out.fill(); pad > 0; --pad)
+        out.put(fill);
+    if(!leftAlign)
+        out.write(s, len);
+}
+
+// Write len characters of s to the stream with padding as for writePadded().
+// If ntrunc is nonnegative, at most ntrunc characters are written.
+// Conversions which build their output directly in a character buffer use
+// this to avoid going through a temporary std::string.
+inline void formatPadded(std::ostream& out, const char* s, std::streamsize len,
+                         int ntrunc = -1)
+{
+    if(ntrunc >= 0 && len > ntrunc)
+        len = ntrunc;
+    writePadded(out, s, len, len);
+}
+
+#ifdef TINYFORMAT_UTF8_DISPLAY_WIDTH
+// Test whether c lies in one of the n sorted, inclusive code point ranges.
+inline bool inCodePointRanges(unsigned long c, const unsigned long (*ranges)[2], int n)
+{
+    int lo = 0, hi = n - 1;
+    if(c < ranges[0][0] || c > ranges[hi][1])
+        return false;
+    while(lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        if(c > ranges[mid][1])
+            lo = mid + 1;
+        else if(c < ranges[mid][0])
+            hi = mid - 1;
+        else
+            return true;
+    }
+    return false;
+}
+
+// Return the number of terminal columns used by the non-ASCII code point c:
+// zero for combining marks and other zero width characters, two for East
+// Asian wide and fullwidth characters and one otherwise.  The tables are a
+// condensed version of those used by Markus Kuhn's wcwidth().
+inline int codePointWidth(unsigned long c)
+{
+    static const unsigned long zeroWidth[][2] = {
+        {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+        {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+        {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+        {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1160, 0x11FF},
+        {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E},
+        {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+        {0xFEFF, 0xFEFF}, {0xE0100, 0xE01EF}
+    };
+    static const unsigned long wide[][2] = {
+        {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x2E80, 0x303E},
+        {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+        {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+        {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x1F300, 0x1F64F},
+        {0x1F900, 0x1F9FF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD}
+    };
+    if(inCodePointRanges(c, zeroWidth, sizeof(zeroWidth)/sizeof(zeroWidth[0])))
+        return 0;
+    if(inCodePointRanges(c, wide, sizeof(wide)/sizeof(wide[0])))
+        return 2;
+    return 1;
+}
+
+// Return the display width in columns of the UTF-8 text [s, s+len).  Runs
+// of ASCII are counted eight bytes at a time.  Malformed or truncated
+// sequences count as one column per byte.
+inline std::streamsize utf8DisplayWidth(const char* s, std::streamsize len)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+    const unsigned char* end = p + len;
+    std::streamsize columns = 0;
+    while(p < end)
+    {
+        unsigned long long word;
+        if(end - p >= 8 && (std::memcpy(&word, p, 8),
+                            (word & TINYFORMAT_U64(0x80808080, 0x80808080)) == 0))
+        {
+            p += 8;
+            columns += 8;
+            continue;
+        }
+        unsigned char b = *p;
+        int nbytes = b < 0x80 ? 1 : b < 0xC2 ? 0 : b < 0xE0 ? 2 : b < 0xF0 ? 3 :
+                     b < 0xF5 ? 4 : 0;
+        if(nbytes == 1)
+        {
+            ++p;
+            ++columns;
+            continue;
+        }
+        unsigned long c = b & (0x7F >> nbytes);
+        int i = 1;
+        for(; i < nbytes && p + i < end && (p[i] & 0xC0) == 0x80; ++i)
+            c = (c << 6) | (p[i] & 0x3F);
+        if(nbytes == 0 || i < nbytes)
+        {
+            // Malformed; step over the lead byte only.
+            ++p;
+            ++columns;
+            continue;
+        }
+        p += nbytes;
+        columns += codePointWidth(c);
+    }
+    return columns;
+}
+#endif // TINYFORMAT_UTF8_DISPLAY_WIDTH
+
+// Write len characters of the string s to the stream, padded to the stream
+// width.  In display width mode the padding is based on the number of
+// terminal columns occupied by the UTF-8 text rather than the byte count.
+inline void formatString(std::ostream& out, const char* s, std::streamsize len)
+{
+#ifdef TINYFORMAT_UTF8_DISPLAY_WIDTH
+    if(out.width() > 0)
+    {
+        writePadded(out, s, len, utf8DisplayWidth(s, len));
+        return;
+    }
+#endif
+    writePadded(out, s, len, len);
+}
+
+// Insert the value into the stream using operator<<.  In display width mode
+// strings are diverted to formatString() so that their padding is correct.
+template<typename T>
+inline void formatStreamed(std::ostream& out, const T& value)
+{
+    out << value;
+}
+#ifdef TINYFORMAT_UTF8_DISPLAY_WIDTH
+inline void formatStreamed(std::ostream& out, const char* value)
+{
+    formatString(out, value, static_cast<std::streamsize>(std::strlen(value)));
+}
+inline void formatStreamed(std::ostream& out, char* value)
+{
+    formatString(out, value, static_cast<std::streamsize>(std::strlen(value)));
+}
+inline void formatStreamed(std::ostream& out, const std::string& value)
+{
+    formatString(out, value.data(), static_cast<std::streamsize>(value.size()));
+}
+#ifdef TINYFORMAT_HAS_STRING_VIEW
+inline void formatStreamed(std::ostream& out, std::string_view value)
+{
+    formatString(out, value.data(), static_cast<std::streamsize>(value.size()));
+}
+#endif
+#endif
+
+#ifdef TINYFORMAT_UTF8_TRUNCATION
+// Return the length of the UTF-8 text [s, s+len) after removing a multi-byte
+// sequence which was cut short at the end.  Only the final few bytes are
+// examined, so this is O(1); malformed text is left alone.
+inline std::streamsize utf8CompleteLength(const char* s, std::streamsize len)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+    if(len == 0 || p[len-1] < 0x80)
+        return len;
+    // Step back over up to three continuation bytes to find the lead byte.
+    std::streamsize lead = len - 1;
+    while(lead > 0 && len - lead < 4 && (p[lead] & 0xC0) == 0x80)
+        --lead;
+    unsigned char b = p[lead];
+    std::streamsize seqLen = b >= 0xF0 ? 4 : b >= 0xE0 ? 3 : b >= 0xC0 ? 2 : 1;
+    return (seqLen > 1 && len - lead < seqLen) ? lead : len;
+}
+#endif
+
+// Write at most ntrunc bytes of the string [s, s+len).  In UTF-8 truncation
+// mode the cut is moved back to a code point boundary so that a multi-byte
+// character is never split.
+inline void formatTruncatedString(std::ostream& out, const char* s,
+                                  std::streamsize len, int ntrunc)
+{
+    if(len >= ntrunc)
+    {
+        len = ntrunc;
+#ifdef TINYFORMAT_UTF8_TRUNCATION
+        len = utf8CompleteLength(s, len);
+#endif
+    }
+    formatString(out, s, len);
+}
+
 // Format at most ntrunc characters to the given stream.
 template<typename T>
 inline void formatTruncated(std::ostream& out, const T& value, int ntrunc)
 {
-    std::ostringstream tmp;
+    SmallStreamBuf<256> buf;
+    std::ostream tmp(&buf);
     tmp << value;
-    std::string result = tmp.str();
-    out.write(result.c_str(), (std::min)(ntrunc, static_cast<int>(result.size())));
+    formatTruncatedString(out, buf.data(), buf.size(), ntrunc);
 }
 #define TINYFORMAT_DEFINE_FORMAT_TRUNCATED_CSTR(type)       \
 inline void formatTruncated(std::ostream& out, type* value, int ntrunc) \
@@ -276,13 +679,250 @@ inline void formatTruncated(std::ostream& out, type* value, int ntrunc) \
     std::streamsize len = 0;                                \
     while(len < ntrunc && value[len] != 0)                  \
         ++len;                                              \
-    out.write(value, len);                                  \
+    formatTruncatedString(out, value, len, ntrunc);         \
 }
 // Overload for const char* and char*.  Could overload for signed & unsigned
 // char too, but these are technically unneeded for printf compatibility.
 TINYFORMAT_DEFINE_FORMAT_TRUNCATED_CSTR(const char)
 TINYFORMAT_DEFINE_FORMAT_TRUNCATED_CSTR(char)
 #undef TINYFORMAT_DEFINE_FORMAT_TRUNCATED_CSTR
+// String classes can be truncated in place without a temporary copy.
+inline void formatTruncated(std::ostream& out, const std::string& value, int ntrunc)
+{
+    formatTruncatedString(out, value.data(),
+                          static_cast<std::streamsize>(value.size()), ntrunc);
+}
+#ifdef TINYFORMAT_HAS_STRING_VIEW
+inline void formatTruncated(std::ostream& out, std::string_view value, int ntrunc)
+{
+    formatTruncatedString(out, value.data(),
+                          static_cast<std::streamsize>(value.size()), ntrunc);
+}
+#endif
+
+// Lookup table of the decimal digit pairs "00" to "99", allowing small
+// integers to be emitted two digits at a time.
+inline const char* decimalDigitPairs()
+{
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233"
+        "34353637383940414243444546474849505152535455565758596061626364656667"
+        "6869707172737475767778798081828384858687888990919293949596979899";
+    return pairs;
+}
+
+// Write the decimal representation of value to p, returning a pointer to one
+// past the last character written.
+inline char* writeDecimal(char* p, unsigned long long value)
+{
+    int ndigits = 1;
+    for(unsigned long long v = value; v >= 10; v /= 10)
+        ++ndigits;
+    char* end = p + ndigits;
+    const char* pairs = decimalDigitPairs();
+    while(value >= 100)
+    {
+        unsigned i = static_cast<unsigned>(value % 100);
+        value /= 100;
+        *--end = pairs[2*i + 1];
+        *--end = pairs[2*i];
+    }
+    if(value >= 10)
+    {
+        *--end = pairs[2*value + 1];
+        *--end = pairs[2*value];
+    }
+    else
+        *--end = static_cast<char>('0' + value);
+    return p + ndigits;
+}
+
+// Write n bytes to p as 2*n hex digits, most significant nibble first.
+inline char* writeHexBytes(char* p, const unsigned char* bytes, int n,
+                           bool upperCase)
+{
+    const char* hexDigits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+    for(int i = 0; i < n; ++i)
+    {
+        p[2*i]     = hexDigits[bytes[i] >> 4];
+        p[2*i + 1] = hexDigits[bytes[i] & 0xf];
+    }
+    return p + 2*n;
+}
+
+#ifdef TINYFORMAT_USE_SOCKADDR
+// Write the dotted quad form of a 4 byte IPv4 address in network byte order.
+inline char* writeIPv4(char* p, const unsigned char* addr)
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        if(i != 0)
+            *p++ = '.';
+        p = writeDecimal(p, addr[i]);
+    }
+    return p;
+}
+
+// Write the text form of a 16 byte IPv6 address in network byte order,
+// following the canonical representation recommended by RFC 5952: lower case
+// hex without leading zeros, with the longest run of two or more zero groups
+// (the first, if tied) compressed to "::", and IPv4-mapped addresses written
+// as ::ffff:a.b.c.d.
+inline char* writeIPv6(char* p, const unsigned char* addr)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    unsigned groups[8];
+    for(int i = 0; i < 8; ++i)
+        groups[i] = (addr[2*i] << 8) | addr[2*i + 1];
+    if(groups[0] == 0 && groups[1] == 0 && groups[2] == 0 && groups[3] == 0 &&
+       groups[4] == 0 && groups[5] == 0xffff)
+    {
+        std::memcpy(p, "::ffff:", 7);
+        return writeIPv4(p + 7, addr + 12);
+    }
+    int bestStart = -1, bestLen = 1;
+    for(int i = 0; i < 8;)
+    {
+        if(groups[i] != 0)
+        {
+            ++i;
+            continue;
+        }
+        int j = i;
+        while(j < 8 && groups[j] == 0)
+            ++j;
+        if(j - i > bestLen)
+        {
+            bestStart = i;
+            bestLen = j - i;
+        }
+        i = j;
+    }
+    for(int i = 0; i < 8; ++i)
+    {
+        if(i == bestStart)
+        {
+            *p++ = ':';
+            if(i + bestLen == 8)
+                *p++ = ':';
+            i += bestLen - 1;
+            continue;
+        }
+        if(i != 0)
+            *p++ = ':';
+        unsigned g = groups[i];
+        int shift = 12;
+        while(shift > 0 && (g >> shift) == 0)
+            shift -= 4;
+        for(; shift >= 0; shift -= 4)
+            *p++ = hexDigits[(g >> shift) & 0xf];
+    }
+    return p;
+}
+
+// Extract a 16 bit port number stored in network byte order.
+inline unsigned long portFromNetworkOrder(const void* port)
+{
+    const unsigned char* b = static_cast<const unsigned char*>(port);
+    return (static_cast<unsigned long>(b[0]) << 8) | b[1];
+}
+#endif // TINYFORMAT_USE_SOCKADDR
+
+// Lookup table of the four bit binary strings "0000" to "1111".
+inline const char* binaryNibbles()
+{
+    static const char nibbles[] =
+        "0000000100100011010001010110011110001001101010111100110111101111";
+    return nibbles;
+}
+
+// Write the binary representation of value to p with no leading zeros,
+// returning a pointer to one past the last character written.  Digits are
+// produced a byte at a time from two table lookups.
+inline char* writeBinary(char* p, unsigned long long value)
+{
+    char digits[64];
+    char* end = digits + sizeof(digits);
+    char* d = end;
+    const char* nibbles = binaryNibbles();
+    do
+    {
+        unsigned byte = static_cast<unsigned>(value & 0xff);
+        d -= 8;
+        std::memcpy(d, nibbles + 4*(byte >> 4), 4);
+        std::memcpy(d + 4, nibbles + 4*(byte & 0xf), 4);
+        value >>= 8;
+    }
+    while(value != 0);
+    while(d != end - 1 && *d == '0')
+        ++d;
+    std::memcpy(p, d, end - d);
+    return p + (end - d);
+}
+
+// Format the bits of an integer in binary for "%b" and "%B", with a prefix of
+// 0b or 0B for the '#' flag.  Padding is as for writePadded(), except that
+// internal padding goes between the prefix and the digits.
+inline void formatBinary(std::ostream& out, unsigned long long value, bool upperCase)
+{
+    char buf[66];
+    char* p = buf;
+    if((out.flags() & std::ios::showbase) && value != 0)
+    {
+        *p++ = '0';
+        *p++ = upperCase ? 'B' : 'b';
+    }
+    std::streamsize prefixLen = p - buf;
+    p = writeBinary(p, value);
+    std::streamsize len = p - buf;
+    if((out.flags() & std::ios::adjustfield) != std::ios::internal)
+    {
+        writePadded(out, buf, len, len);
+        return;
+    }
+    std::streamsize pad = out.width() - len;
+    out.width(0);
+    out.write(buf, prefixLen);
+    for(char fill = out.fill(); pad > 0; --pad)
+        out.put(fill);
+    out.write(buf + prefixLen, len - prefixLen);
+}
+
+// Format integer types in binary; other types aren't handled, and are
+// formatted as usual.  Negative values give the two's complement bits of the
+// type itself, so unlike "%x", char types give eight bits.
+template<typename T> struct formatBinaryIfInteger
+{
+    static bool invoke(std::ostream& /*out*/, const T& /*value*/, bool /*upperCase*/)
+        { return false; }
+};
+#define TINYFORMAT_DEFINE_FORMAT_BINARY(intType)                          \
+template<> struct formatBinaryIfInteger<intType>                          \
+{                                                                         \
+    static bool invoke(std::ostream& out, intType value, bool upperCase)  \
+    {                                                                     \
+        unsigned long long bits = static_cast<unsigned long long>(value); \
+        /* "% 64" avoids a shift width warning for 64 bit types */     \
+        if(sizeof(intType) < sizeof(bits))                                \
+            bits &= (static_cast<unsigned long long>(1) <<              \
+                     (8*sizeof(intType) % 64)) - 1;                       \
+        formatBinary(out, bits, upperCase);                               \
+        return true;                                                      \
+    }                                                                     \
+};
+TINYFORMAT_DEFINE_FORMAT_BINARY(bool)
+TINYFORMAT_DEFINE_FORMAT_BINARY(char)
+TINYFORMAT_DEFINE_FORMAT_BINARY(signed char)
+TINYFORMAT_DEFINE_FORMAT_BINARY(unsigned char)
+TINYFORMAT_DEFINE_FORMAT_BINARY(short)
+TINYFORMAT_DEFINE_FORMAT_BINARY(unsigned short)
+TINYFORMAT_DEFINE_FORMAT_BINARY(int)
+TINYFORMAT_DEFINE_FORMAT_BINARY(unsigned int)
+TINYFORMAT_DEFINE_FORMAT_BINARY(long)
+TINYFORMAT_DEFINE_FORMAT_BINARY(unsigned long)
+TINYFORMAT_DEFINE_FORMAT_BINARY(long long)
+TINYFORMAT_DEFINE_FORMAT_BINARY(unsigned long long)
+#undef TINYFORMAT_DEFINE_FORMAT_BINARY
 
 } // namespace detail
 
@@ -324,6 +964,9 @@ inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
         detail::formatValueAsType<T, char>::invoke(out, value);
     else if(canConvertToVoidPtr && *(fmtEnd-1) == 'p')
         detail::formatValueAsType<T, const void*>::invoke(out, value);
+    else if((*(fmtEnd-1) == 'b' || *(fmtEnd-1) == 'B') &&
+            detail::formatBinaryIfInteger<T>::invoke(out, value, *(fmtEnd-1) == 'B'))
+        /**/;
 #ifdef TINYFORMAT_OLD_LIBSTDCPLUSPLUS_WORKAROUND
     else if(detail::formatZeroIntegerWorkaround<T>::invoke(out, value)) /**/;
 #endif
@@ -334,7 +977,7 @@ inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
         detail::formatTruncated(out, value, ntrunc);
     }
     else
-        out << value;
+        detail::formatStreamed(out, value);
 }
 
 
@@ -347,6 +990,9 @@ inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,  \
     {                                                                 \
         case 'u': case 'd': case 'i': case 'o': case 'X': case 'x':   \
             out << static_cast<int>(value); break;                    \
+        case 'b': case 'B':                                           \
+            detail::formatBinaryIfInteger<charType>::invoke(out,      \
+                value, *(fmtEnd-1) == 'B'); break;                    \
         default:                                                      \
             out << value;                   break;                    \
     }                                                                 \
@@ -358,66 +1004,482 @@ TINYFORMAT_DEFINE_FORMATVALUE_CHAR(unsigned char)
 #undef TINYFORMAT_DEFINE_FORMATVALUE_CHAR
 
 
-//------------------------------------------------------------------------------
-// Tools for emulating variadic templates in C++98.  The basic idea here is
-// stolen from the boost preprocessor metaprogramming library and cut down to
-// be just general enough for what we need.
+#ifdef TINYFORMAT_USE_SOCKADDR
+// Overloads for socket addresses.  The text is built directly in a stack
+// buffer rather than via inet_ntop() and a temporary string.  Socket
+// addresses with a port are written as a.b.c.d:port and [v6addr]:port.
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc, const in_addr& addr)
+{
+    char buf[16];
+    const char* end = detail::writeIPv4(buf, reinterpret_cast<const unsigned char*>(&addr));
+    detail::formatPadded(out, buf, end - buf, ntrunc);
+}
 
-#define TINYFORMAT_ARGTYPES(n) TINYFORMAT_ARGTYPES_ ## n
-#define TINYFORMAT_VARARGS(n) TINYFORMAT_VARARGS_ ## n
-#define TINYFORMAT_PASSARGS(n) TINYFORMAT_PASSARGS_ ## n
-#define TINYFORMAT_PASSARGS_TAIL(n) TINYFORMAT_PASSARGS_TAIL_ ## n
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc, const in6_addr& addr)
+{
+    char buf[48];
+    const char* end = detail::writeIPv6(buf, addr.s6_addr);
+    detail::formatPadded(out, buf, end - buf, ntrunc);
+}
 
-// To keep it as transparent as possible, the macros below have been generated
-// using python via the excellent cog.py code generation script.  This avoids
-// the need for a bunch of complex (but more general) preprocessor tricks as
-// used in boost.preprocessor.
-//
-// To rerun the code generation in place, use `cog.py -r tinyformat.h`
-// (see http://nedbatchelder.com/code/cog).  Alternatively you can just create
-// extra versions by hand.
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc, const sockaddr_in& addr)
+{
+    char buf[24];
+    char* p = detail::writeIPv4(buf, reinterpret_cast<const unsigned char*>(&addr.sin_addr));
+    *p++ = ':';
+    p = detail::writeDecimal(p, detail::portFromNetworkOrder(&addr.sin_port));
+    detail::formatPadded(out, buf, p - buf, ntrunc);
+}
 
-/*[[[cog
-maxParams = 16
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc, const sockaddr_in6& addr)
+{
+    char buf[72];
+    char* p = buf;
+    *p++ = '[';
+    p = detail::writeIPv6(p, addr.sin6_addr.s6_addr);
+    if(addr.sin6_scope_id != 0)
+    {
+        *p++ = '%';
+        p = detail::writeDecimal(p, addr.sin6_scope_id);
+    }
+    *p++ = ']';
+    *p++ = ':';
+    p = detail::writeDecimal(p, detail::portFromNetworkOrder(&addr.sin6_port));
+    detail::formatPadded(out, buf, p - buf, ntrunc);
+}
+#endif // TINYFORMAT_USE_SOCKADDR
 
-def makeCommaSepLists(lineTemplate, elemTemplate, startInd=1):
-    for j in range(startInd,maxParams+1):
-        list = ', '.join([elemTemplate % {'i':i} for i in range(startInd,j+1)])
-        cog.outl(lineTemplate % {'j':j, 'list':list})
 
-makeCommaSepLists('#define TINYFORMAT_ARGTYPES_%(j)d %(list)s',
-                  'class T%(i)d')
+/// Wrapper for formatting 16 raw bytes as a UUID, as returned by uuid().
+class UuidValue
+{
+    public:
+        explicit UuidValue(const void* bytes)
+            { std::memcpy(m_bytes, bytes, 16); }
 
-cog.outl()
-makeCommaSepLists('#define TINYFORMAT_VARARGS_%(j)d %(list)s',
-                  'const T%(i)d& v%(i)d')
+        const unsigned char* bytes() const { return m_bytes; }
 
-cog.outl()
-makeCommaSepLists('#define TINYFORMAT_PASSARGS_%(j)d %(list)s', 'v%(i)d')
+    private:
+        unsigned char m_bytes[16];
+};
 
-cog.outl()
-cog.outl('#define TINYFORMAT_PASSARGS_TAIL_1')
-makeCommaSepLists('#define TINYFORMAT_PASSARGS_TAIL_%(j)d , %(list)s',
-                  'v%(i)d', startInd = 2)
+/// Wrapper for formatting an 8 or 16 byte identifier as a fixed width string
+/// of hex digits, as returned by hexId().
+class HexIdValue
+{
+    public:
+        HexIdValue(unsigned long long hi, unsigned long long lo, int nbytes)
+            : m_nbytes(nbytes)
+        {
+            for(int i = 0; i < 8; ++i)
+            {
+                m_bytes[7 - i] = static_cast<unsigned char>(hi >> 8*i);
+                m_bytes[15 - i] = static_cast<unsigned char>(lo >> 8*i);
+            }
+        }
 
-cog.outl()
-cog.outl('#define TINYFORMAT_FOREACH_ARGNUM(m) \\\n    ' +
-         ' '.join(['m(%d)' % (j,) for j in range(1,maxParams+1)]))
-]]]*/
-#define TINYFORMAT_ARGTYPES_1 class T1
-#define TINYFORMAT_ARGTYPES_2 class T1, class T2
-#define TINYFORMAT_ARGTYPES_3 class T1, class T2, class T3
-#define TINYFORMAT_ARGTYPES_4 class T1, class T2, class T3, class T4
-#define TINYFORMAT_ARGTYPES_5 class T1, class T2, class T3, class T4, class T5
-#define TINYFORMAT_ARGTYPES_6 class T1, class T2, class T3, class T4, class T5, class T6
-#define TINYFORMAT_ARGTYPES_7 class T1, class T2, class T3, class T4, class T5, class T6, class T7
-#define TINYFORMAT_ARGTYPES_8 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8
-#define TINYFORMAT_ARGTYPES_9 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9
-#define TINYFORMAT_ARGTYPES_10 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10
-#define TINYFORMAT_ARGTYPES_11 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11
-#define TINYFORMAT_ARGTYPES_12 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12
-#define TINYFORMAT_ARGTYPES_13 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12, class T13
-#define TINYFORMAT_ARGTYPES_14 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12, class T13, class T14
+        const unsigned char* bytes() const { return m_bytes + 16 - m_nbytes; }
+        int size() const { return m_nbytes; }
+
+    private:
+        unsigned char m_bytes[16];
+        int m_nbytes;
+};
+
+/// Format the 16 bytes at the given address as a UUID in the canonical
+/// 8-4-4-4-12 layout, for example "%s" gives
+/// 123e4567-e89b-12d3-a456-426614174000.  "%X" gives upper case hex digits.
+inline UuidValue uuid(const void* bytes)
+{
+    return UuidValue(bytes);
+}
+
+/// Format a 64 bit identifier as exactly 16 hex digits, including leading
+/// zeros.  "%X" gives upper case hex digits.
+inline HexIdValue hexId(unsigned long long id)
+{
+    return HexIdValue(0, id, 8);
+}
+
+/// Format a 128 bit identifier given as high and low halves as exactly 32 hex
+/// digits, as used for trace IDs.
+inline HexIdValue hexId(unsigned long long hi, unsigned long long lo)
+{
+    return HexIdValue(hi, lo, 16);
+}
+
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* fmtEnd, int ntrunc, const UuidValue& id)
+{
+    bool upperCase = *(fmtEnd-1) == 'X';
+    const unsigned char* b = id.bytes();
+    char buf[36];
+    char* p = detail::writeHexBytes(buf, b, 4, upperCase);
+    *p++ = '-';
+    p = detail::writeHexBytes(p, b + 4, 2, upperCase);
+    *p++ = '-';
+    p = detail::writeHexBytes(p, b + 6, 2, upperCase);
+    *p++ = '-';
+    p = detail::writeHexBytes(p, b + 8, 2, upperCase);
+    *p++ = '-';
+    p = detail::writeHexBytes(p, b + 10, 6, upperCase);
+    detail::formatPadded(out, buf, p - buf, ntrunc);
+}
+
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* fmtEnd, int ntrunc, const HexIdValue& id)
+{
+    char buf[32];
+    char* p = detail::writeHexBytes(buf, id.bytes(), id.size(), *(fmtEnd-1) == 'X');
+    detail::formatPadded(out, buf, p - buf, ntrunc);
+}
+
+
+/// Wrapper for formatting an integer with an implied number of decimal
+/// places, as returned by decimal().
+class DecimalValue
+{
+    public:
+        DecimalValue(long long value, int decimals)
+            : m_value(value), m_decimals(decimals) { }
+
+        long long value() const { return m_value; }
+        int decimals() const { return m_decimals; }
+
+    private:
+        long long m_value;
+        int m_decimals;
+};
+
+/// Format the scaled integer value as a decimal number with the given number
+/// of implied decimal places, so decimal(12345, 2) formats as 123.45.  With
+/// "%f" the precision rounds or extends the fraction using integer
+/// arithmetic only, rounding half to even; other conversions except "%e" and
+/// "%g" give exactly the implied decimal places.
+inline DecimalValue decimal(long long value, int decimals)
+{
+    return DecimalValue(value, decimals);
+}
+
+namespace detail {
+// Write a scaled integer with precision decimal places, padded according to
+// the stream width and flags as for a floating point value.
+inline void formatDecimal(std::ostream& out, long long value, int decimals,
+                          int precision, int ntrunc)
+{
+    unsigned long long mag = value < 0 ? 0 - static_cast<unsigned long long>(value)
+                                       : static_cast<unsigned long long>(value);
+    unsigned long long n = mag;
+    int fracDigits = decimals;
+    if(precision < decimals)
+    {
+        // Drop the excess digits, rounding half to even
+        unsigned long long div = 1;
+        for(int i = precision; i < decimals; ++i)
+            div *= 10;
+        unsigned long long r = mag % div;
+        n = mag / div;
+        if(r > div/2 || (r == div/2 && (n & 1)))
+            ++n;
+        fracDigits = precision;
+    }
+    // Digits of n, with a decimal point before the last fracDigits
+    char buf[48];
+    char* p = buf;
+    if(value < 0)
+        *p++ = '-';
+    else if(out.flags() & std::ios::showpos)
+        *p++ = '+';
+    int signLen = static_cast<int>(p - buf);
+    unsigned long long scale = 1;
+    for(int i = 0; i < fracDigits; ++i)
+        scale *= 10;
+    p = writeDecimal(p, n / scale);
+    if(precision > 0 || (out.flags() & std::ios::showpoint))
+        *p++ = '.';
+    unsigned long long frac = n % scale;
+    p += fracDigits;
+    for(char* d = p; d != p - fracDigits; frac /= 10)
+        *--d = static_cast<char>('0' + frac % 10);
+    int zeros = precision > decimals ? precision - decimals : 0;
+    std::streamsize len = (p - buf) + zeros;
+    if(ntrunc >= 0)
+    {
+        // Only for "%.Ns", where there are no extra zeros
+        formatPadded(out, buf, p - buf, ntrunc);
+        return;
+    }
+    std::streamsize pad = out.width() - len;
+    out.width(0);
+    std::ios::fmtflags adjust = out.flags() & std::ios::adjustfield;
+    char fill = out.fill();
+    if(adjust != std::ios::left && adjust != std::ios::internal)
+        for(; pad > 0; --pad)
+            out.put(fill);
+    out.write(buf, signLen);
+    for(; pad > 0 && adjust == std::ios::internal; --pad)
+        out.put(fill);
+    out.write(buf + signLen, (p - buf) - signLen);
+    for(; zeros > 0; --zeros)
+        out.put('0');
+    for(; pad > 0; --pad)
+        out.put(fill);
+}
+} // namespace detail
+
+inline void formatValue(std::ostream& out, const char* fmtBegin,
+                        const char* fmtEnd, int ntrunc, const DecimalValue& d)
+{
+    int decimals = d.decimals();
+    if(decimals < 0 || decimals > 19)
+    {
+        TINYFORMAT_ERROR("tinyformat: decimal() supports 0 to 19 decimal places");
+        return;
+    }
+    switch(*(fmtEnd-1))
+    {
+        case 'f': case 'F':
+            detail::formatDecimal(out, d.value(), decimals,
+                                  static_cast<int>(out.precision()), -1);
+            break;
+        case 'e': case 'E': case 'g': case 'G':
+        {
+            // Only fixed notation is handled exactly
+            long double scale = 1;
+            for(int i = 0; i < decimals; ++i)
+                scale *= 10;
+            formatValue(out, fmtBegin, fmtEnd, ntrunc, d.value() / scale);
+            break;
+        }
+        default:
+            detail::formatDecimal(out, d.value(), decimals, decimals, ntrunc);
+            break;
+    }
+}
+
+
+#if defined(TINYFORMAT_HAS_SMART_POINTERS) || defined(TINYFORMAT_HAS_OPTIONAL_VARIANT)
+namespace detail {
+inline void formatNone(std::ostream& out, int ntrunc)
+{
+    formatPadded(out, TINYFORMAT_NONE_TEXT,
+                 static_cast<std::streamsize>(std::strlen(TINYFORMAT_NONE_TEXT)),
+                 ntrunc);
+}
+} // namespace detail
+#endif
+
+// Overloads for wrapper types from the standard library, which format the
+// wrapped value with the same format spec.  They may be nested inside each
+// other, so are all declared before any is defined.
+#ifdef TINYFORMAT_HAS_SMART_POINTERS
+template<typename T, typename D>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::unique_ptr<T, D>& value);
+template<typename T>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::shared_ptr<T>& value);
+#endif
+#ifdef TINYFORMAT_HAS_OPTIONAL_VARIANT
+template<typename T>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::optional<T>& value);
+template<typename... Ts>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::variant<Ts...>& value);
+#endif
+
+#ifdef TINYFORMAT_HAS_SMART_POINTERS
+namespace detail {
+// Detect a formatValue() overload for T found by argument dependent lookup,
+// as defined by TINYFORMAT_FORMAT_FIELDS.  The variadic fallback is chosen
+// only if there is none.
+namespace pointee_probe {
+struct NoFormatValue {};
+NoFormatValue formatValue(...);
+
+template<typename T>
+struct hasFormatValue
+{
+    static const bool value = !std::is_same<NoFormatValue,
+        decltype(formatValue(std::declval<std::ostream&>(), static_cast<const char*>(0),
+                             static_cast<const char*>(0), 0, std::declval<const T&>()))>::value;
+};
+} // namespace pointee_probe
+
+// Test whether the object pointed to by a smart pointer can be formatted:
+// it must have operator<< or a formatValue() overload.  Other pointees,
+// including void and arrays, are formatted as the pointer itself.
+template<typename T>
+struct canFormatPointee
+{
+    private:
+        template<typename U>
+        static auto test(int) -> decltype(std::declval<std::ostream&>() << std::declval<const U&>(),
+                                          std::true_type());
+        template<typename U>
+        static std::false_type test(...);
+    public:
+        static const bool value = decltype(test<T>(0))::value ||
+                                  pointee_probe::hasFormatValue<T>::value;
+};
+template<> struct canFormatPointee<void> { static const bool value = false; };
+template<> struct canFormatPointee<const void> { static const bool value = false; };
+template<typename T>
+struct canFormatPointee<T[]> { static const bool value = false; };
+template<typename T, size_t N>
+struct canFormatPointee<T[N]> { static const bool value = false; };
+template<typename T, typename D>
+struct canFormatPointee<std::unique_ptr<T, D> > { static const bool value = true; };
+template<typename T>
+struct canFormatPointee<std::shared_ptr<T> > { static const bool value = true; };
+#ifdef TINYFORMAT_HAS_OPTIONAL_VARIANT
+template<typename T>
+struct canFormatPointee<std::optional<T> > { static const bool value = true; };
+template<typename... Ts>
+struct canFormatPointee<std::variant<Ts...> > { static const bool value = true; };
+#endif
+
+// "%p" formats the pointer itself; other conversions format the object it
+// points to, or TINYFORMAT_NONE_TEXT for a null pointer.
+template<typename T, bool canFormat = canFormatPointee<T>::value>
+struct formatSmartPointer
+{
+    static void invoke(std::ostream& out, const char* /*fmtBegin*/,
+                       const char* /*fmtEnd*/, int /*ntrunc*/,
+                       const typename std::remove_extent<T>::type* p)
+    {
+        out << static_cast<const void*>(p);
+    }
+};
+
+template<typename T>
+struct formatSmartPointer<T, true>
+{
+    static void invoke(std::ostream& out, const char* fmtBegin,
+                       const char* fmtEnd, int ntrunc, const T* p)
+    {
+        if(*(fmtEnd-1) == 'p')
+            out << static_cast<const void*>(p);
+        else if(p)
+            formatValue(out, fmtBegin, fmtEnd, ntrunc, *p);
+        else
+            formatNone(out, ntrunc);
+    }
+};
+} // namespace detail
+
+template<typename T, typename D>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::unique_ptr<T, D>& value)
+{
+    detail::formatSmartPointer<T>::invoke(out, fmtBegin, fmtEnd, ntrunc, value.get());
+}
+
+template<typename T>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::shared_ptr<T>& value)
+{
+    detail::formatSmartPointer<T>::invoke(out, fmtBegin, fmtEnd, ntrunc, value.get());
+}
+#endif // TINYFORMAT_HAS_SMART_POINTERS
+
+#ifdef TINYFORMAT_HAS_OPTIONAL_VARIANT
+template<typename T>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::optional<T>& value)
+{
+    if(value)
+        formatValue(out, fmtBegin, fmtEnd, ntrunc, *value);
+    else
+        detail::formatNone(out, ntrunc);
+}
+
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc, std::monostate)
+{
+    detail::formatNone(out, ntrunc);
+}
+
+// The active alternative is formatted as if it had been passed directly.
+template<typename... Ts>
+void formatValue(std::ostream& out, const char* fmtBegin, const char* fmtEnd,
+                 int ntrunc, const std::variant<Ts...>& value)
+{
+    if(value.valueless_by_exception())
+        detail::formatNone(out, ntrunc);
+    else
+        std::visit([&](const auto& alternative) {
+            formatValue(out, fmtBegin, fmtEnd, ntrunc, alternative);
+        }, value);
+}
+#endif // TINYFORMAT_HAS_OPTIONAL_VARIANT
+
+
+//------------------------------------------------------------------------------
+// Tools for emulating variadic templates in C++98.  The basic idea here is
+// stolen from the boost preprocessor metaprogramming library and cut down to
+// be just general enough for what we need.
+
+#define TINYFORMAT_ARGTYPES(n) TINYFORMAT_ARGTYPES_ ## n
+#define TINYFORMAT_VARARGS(n) TINYFORMAT_VARARGS_ ## n
+#define TINYFORMAT_PASSARGS(n) TINYFORMAT_PASSARGS_ ## n
+#define TINYFORMAT_PASSARGS_TAIL(n) TINYFORMAT_PASSARGS_TAIL_ ## n
+
+// To keep it as transparent as possible, the macros below have been generated
+// using python via the excellent cog.py code generation script.  This avoids
+// the need for a bunch of complex (but more general) preprocessor tricks as
+// used in boost.preprocessor.
+//
+// To rerun the code generation in place, use `cog.py -r tinyformat.h`
+// (see http://nedbatchelder.com/code/cog).  Alternatively you can just create
+// extra versions by hand.
+
+/*[[[cog
+maxParams = 16
+
+def makeCommaSepLists(lineTemplate, elemTemplate, startInd=1):
+    for j in range(startInd,maxParams+1):
+        list = ', '.join([elemTemplate % {'i':i} for i in range(startInd,j+1)])
+        cog.outl(lineTemplate % {'j':j, 'list':list})
+
+makeCommaSepLists('#define TINYFORMAT_ARGTYPES_%(j)d %(list)s',
+                  'class T%(i)d')
+
+cog.outl()
+makeCommaSepLists('#define TINYFORMAT_VARARGS_%(j)d %(list)s',
+                  'const T%(i)d& v%(i)d')
+
+cog.outl()
+makeCommaSepLists('#define TINYFORMAT_PASSARGS_%(j)d %(list)s', 'v%(i)d')
+
+cog.outl()
+cog.outl('#define TINYFORMAT_PASSARGS_TAIL_1')
+makeCommaSepLists('#define TINYFORMAT_PASSARGS_TAIL_%(j)d , %(list)s',
+                  'v%(i)d', startInd = 2)
+
+cog.outl()
+cog.outl('#define TINYFORMAT_FOREACH_ARGNUM(m) \\\n    ' +
+         ' '.join(['m(%d)' % (j,) for j in range(1,maxParams+1)]))
+]]]*/
+#define TINYFORMAT_ARGTYPES_1 class T1
+#define TINYFORMAT_ARGTYPES_2 class T1, class T2
+#define TINYFORMAT_ARGTYPES_3 class T1, class T2, class T3
+#define TINYFORMAT_ARGTYPES_4 class T1, class T2, class T3, class T4
+#define TINYFORMAT_ARGTYPES_5 class T1, class T2, class T3, class T4, class T5
+#define TINYFORMAT_ARGTYPES_6 class T1, class T2, class T3, class T4, class T5, class T6
+#define TINYFORMAT_ARGTYPES_7 class T1, class T2, class T3, class T4, class T5, class T6, class T7
+#define TINYFORMAT_ARGTYPES_8 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8
+#define TINYFORMAT_ARGTYPES_9 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9
+#define TINYFORMAT_ARGTYPES_10 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10
+#define TINYFORMAT_ARGTYPES_11 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11
+#define TINYFORMAT_ARGTYPES_12 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12
+#define TINYFORMAT_ARGTYPES_13 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12, class T13
+#define TINYFORMAT_ARGTYPES_14 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12, class T13, class T14
 #define TINYFORMAT_ARGTYPES_15 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12, class T13, class T14, class T15
 #define TINYFORMAT_ARGTYPES_16 class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10, class T11, class T12, class T13, class T14, class T15, class T16
 
@@ -480,6 +1542,77 @@ cog.outl('#define TINYFORMAT_FOREACH_ARGNUM(m) \\\n    ' +
 
 namespace detail {
 
+// Tags for the built in argument types, allowing sinks which store
+// arguments for later formatting to copy their values without knowing the
+// static type.  Other types are tagged ArgOther.
+enum ArgType
+{
+    ArgOther,
+    ArgBool, ArgChar, ArgSChar, ArgUChar,
+    ArgShort, ArgUShort, ArgInt, ArgUInt,
+    ArgLong, ArgULong, ArgLongLong, ArgULongLong,
+    ArgFloat, ArgDouble, ArgLongDouble,
+    ArgCString,    // value points to a const char* or char*
+    ArgCharArray,  // value points to the first char of a char array
+    ArgStdString,
+    ArgPointer     // value points to a void* or const void*
+};
+
+// Pointers other than char and void pointers are tagged ArgOther: they may
+// be formatted as strings (unsigned char*) or by a user operator<<, so
+// their value alone doesn't determine the output.
+template<typename T> struct argTypeOf { static const int value = ArgOther; };
+template<std::size_t N> struct argTypeOf<char[N]> { static const int value = ArgCharArray; };
+
+// Number of elements of a char array, which needn't be null terminated
+template<typename T> struct charArraySize { static const int value = 0; };
+template<std::size_t N> struct charArraySize<char[N]> { static const int value = static_cast<int>(N); };
+
+// Types formatted as narrow strings, which std::format style fields align
+// left by default
+template<typename T> struct isStringType { static const bool value = false; };
+template<std::size_t N> struct isStringType<char[N]> { static const bool value = true; };
+template<typename Traits, typename Alloc>
+struct isStringType<std::basic_string<char, Traits, Alloc> > { static const bool value = true; };
+#ifdef TINYFORMAT_HAS_STRING_VIEW
+template<typename Traits>
+struct isStringType<std::basic_string_view<char, Traits> > { static const bool value = true; };
+#endif
+#define TINYFORMAT_DEFINE_STRING_TYPE(type)                      \
+template<> struct isStringType<type> { static const bool value = true; };
+TINYFORMAT_DEFINE_STRING_TYPE(char*)
+TINYFORMAT_DEFINE_STRING_TYPE(const char*)
+TINYFORMAT_DEFINE_STRING_TYPE(signed char*)
+TINYFORMAT_DEFINE_STRING_TYPE(const signed char*)
+TINYFORMAT_DEFINE_STRING_TYPE(unsigned char*)
+TINYFORMAT_DEFINE_STRING_TYPE(const unsigned char*)
+#undef TINYFORMAT_DEFINE_STRING_TYPE
+
+#define TINYFORMAT_DEFINE_ARGTYPE(type, tag)                     \
+template<> struct argTypeOf<type> { static const int value = tag; };
+TINYFORMAT_DEFINE_ARGTYPE(bool, ArgBool)
+TINYFORMAT_DEFINE_ARGTYPE(char, ArgChar)
+TINYFORMAT_DEFINE_ARGTYPE(signed char, ArgSChar)
+TINYFORMAT_DEFINE_ARGTYPE(unsigned char, ArgUChar)
+TINYFORMAT_DEFINE_ARGTYPE(short, ArgShort)
+TINYFORMAT_DEFINE_ARGTYPE(unsigned short, ArgUShort)
+TINYFORMAT_DEFINE_ARGTYPE(int, ArgInt)
+TINYFORMAT_DEFINE_ARGTYPE(unsigned int, ArgUInt)
+TINYFORMAT_DEFINE_ARGTYPE(long, ArgLong)
+TINYFORMAT_DEFINE_ARGTYPE(unsigned long, ArgULong)
+TINYFORMAT_DEFINE_ARGTYPE(long long, ArgLongLong)
+TINYFORMAT_DEFINE_ARGTYPE(unsigned long long, ArgULongLong)
+TINYFORMAT_DEFINE_ARGTYPE(float, ArgFloat)
+TINYFORMAT_DEFINE_ARGTYPE(double, ArgDouble)
+TINYFORMAT_DEFINE_ARGTYPE(long double, ArgLongDouble)
+TINYFORMAT_DEFINE_ARGTYPE(char*, ArgCString)
+TINYFORMAT_DEFINE_ARGTYPE(const char*, ArgCString)
+TINYFORMAT_DEFINE_ARGTYPE(std::string, ArgStdString)
+TINYFORMAT_DEFINE_ARGTYPE(void*, ArgPointer)
+TINYFORMAT_DEFINE_ARGTYPE(const void*, ArgPointer)
+#undef TINYFORMAT_DEFINE_ARGTYPE
+
+
 // Type-opaque holder for an argument to format(), with associated actions on
 // the type held as explicit function pointers.  This allows FormatArg's for
 // each argument to be allocated as a homogenous array inside FormatList
@@ -493,7 +1626,10 @@ class FormatArg
         FormatArg(const T& value)
             : m_value(static_cast<const void*>(&value)),
             m_formatImpl(&formatImpl<T>),
-            m_toIntImpl(&toIntImpl<T>)
+            m_toIntImpl(&toIntImpl<T>),
+            m_type(argTypeOf<T>::value),
+            m_arraySize(charArraySize<T>::value),
+            m_isString(isStringType<T>::value)
         { }
 
         void format(std::ostream& out, const char* fmtBegin,
@@ -507,6 +1643,15 @@ class FormatArg
             return m_toIntImpl(m_value);
         }
 
+        /// Type tag from ArgType and address of the argument value
+        int type() const { return m_type; }
+        const void* value() const { return m_value; }
+        /// Number of chars for an ArgCharArray argument
+        int arraySize() const { return m_arraySize; }
+        /// Whether the argument is formatted as a string, including types
+        /// tagged ArgOther such as std::string_view
+        bool isString() const { return m_isString; }
+
     private:
         template<typename T>
         TINYFORMAT_HIDDEN static void formatImpl(std::ostream& out, const char* fmtBegin,
@@ -525,6 +1670,9 @@ class FormatArg
         void (*m_formatImpl)(std::ostream& out, const char* fmtBegin,
                              const char* fmtEnd, int ntrunc, const void* value);
         int (*m_toIntImpl)(const void* value);
+        int m_type;
+        int m_arraySize;
+        bool m_isString;
 };
 
 
@@ -708,6 +1856,12 @@ inline const char* streamStateFromFormat(std::ostream& out, bool& spacePadPositi
             out.setf(std::ios::hex, std::ios::basefield);
             intConversion = true;
             break;
+        case 'b': case 'B':
+            // Binary has no stream equivalent; integers are written by
+            // formatValue() and other types formatted as for "%d".
+            out.setf(std::ios::dec, std::ios::basefield);
+            intConversion = true;
+            break;
         case 'E':
             out.setf(std::ios::uppercase);
         case 'e':
@@ -765,6 +1919,34 @@ inline const char* streamStateFromFormat(std::ostream& out, bool& spacePadPositi
 
 
 //------------------------------------------------------------------------------
+// Format a single argument into the stream, after the stream state has been
+// set up by streamStateFromFormat().
+inline void formatArgument(std::ostream& out, const FormatArg& arg,
+                           const char* fmt, const char* fmtEnd, int ntrunc,
+                           bool spacePadPositive)
+{
+    if(!spacePadPositive)
+        arg.format(out, fmt, fmtEnd, ntrunc);
+    else
+    {
+        // The following is a special case with no direct correspondence
+        // between stream formatting and the printf() behaviour.  Simulate
+        // it crudely by formatting into a temporary buffer and munging the
+        // result.
+        SmallStreamBuf<256> buf;
+        std::ostream tmpStream(&buf);
+        tmpStream.copyfmt(out);
+        tmpStream.setf(std::ios::showpos);
+        arg.format(tmpStream, fmt, fmtEnd, ntrunc);
+        char* result = buf.data();
+        for(std::streamsize i = 0, iend = buf.size(); i < iend; ++i)
+            if(result[i] == '+') result[i] = ' ';
+        out.width(0);
+        out.write(result, buf.size());
+    }
+}
+
+
 inline void formatImpl(std::ostream& out, const char* fmt,
                        const detail::FormatArg* formatters,
                        int numFormatters)
@@ -789,25 +1971,9 @@ inline void formatImpl(std::ostream& out, const char* fmt,
             TINYFORMAT_ERROR("tinyformat: Not enough format arguments");
             return;
         }
-        const FormatArg& arg = formatters[argIndex];
         // Format the arg into the stream.
-        if(!spacePadPositive)
-            arg.format(out, fmt, fmtEnd, ntrunc);
-        else
-        {
-            // The following is a special case with no direct correspondence
-            // between stream formatting and the printf() behaviour.  Simulate
-            // it crudely by formatting into a temporary string stream and
-            // munging the resulting string.
-            std::ostringstream tmpStream;
-            tmpStream.copyfmt(out);
-            tmpStream.setf(std::ios::showpos);
-            arg.format(tmpStream, fmt, fmtEnd, ntrunc);
-            std::string result = tmpStream.str(); // allocates... yuck.
-            for(size_t i = 0, iend = result.size(); i < iend; ++i)
-                if(result[i] == '+') result[i] = ' ';
-            out << result;
-        }
+        formatArgument(out, formatters[argIndex], fmt, fmtEnd, ntrunc,
+                       spacePadPositive);
         fmt = fmtEnd;
     }
 
@@ -823,40 +1989,891 @@ inline void formatImpl(std::ostream& out, const char* fmt,
     out.fill(origFill);
 }
 
-} // namespace detail
-
 
-/// List of template arguments format(), held in a type-opaque way.
-///
-/// A const reference to FormatList (typedef'd as FormatListRef) may be
-/// conveniently used to pass arguments to non-template functions: All type
-/// information has been stripped from the arguments, leaving just enough of a
-/// common interface to perform formatting as required.
-class FormatList
+// Format each argument as for "%s".  The spec is parsed once, rather than
+// once per argument as for a format string.
+inline void catImpl(std::ostream& out, const detail::FormatArg* formatters,
+                    int numFormatters)
 {
-    public:
-        FormatList(detail::FormatArg* formatters, int N)
-            : m_formatters(formatters), m_N(N) { }
-
-        friend void vformat(std::ostream& out, const char* fmt,
-                            const FormatList& list);
-
-    private:
-        const detail::FormatArg* m_formatters;
-        int m_N;
-};
-
-/// Reference to type-opaque format list for passing to vformat()
-typedef const FormatList& FormatListRef;
-
+    static const char spec[] = "%s";
+    std::streamsize origWidth = out.width();
+    std::streamsize origPrecision = out.precision();
+    std::ios::fmtflags origFlags = out.flags();
+    char origFill = out.fill();
+    bool spacePadPositive = false;
+    int ntrunc = -1;
+    int argIndex = 0;
+    const char* specEnd = streamStateFromFormat(out, spacePadPositive, ntrunc,
+                                                spec, 0, argIndex, 0);
+    for(int i = 0; i < numFormatters; ++i)
+        formatters[i].format(out, spec, specEnd, ntrunc);
+    out.width(origWidth);
+    out.precision(origPrecision);
+    out.flags(origFlags);
+    out.fill(origFill);
+}
 
-namespace detail {
+// Format the elements from begin to end using the single conversion spec
+// elemSpec, with sep between them.  The spec is parsed once for the whole
+// range.
+template<typename Iterator>
+void formatJoined(std::ostream& out, Iterator begin, Iterator end,
+                  const char* sep, const char* elemSpec)
+{
+    if(*elemSpec != '%')
+    {
+        TINYFORMAT_ERROR("tinyformat: Join element spec must be a single conversion");
+        return;
+    }
+    std::streamsize origWidth = out.width();
+    std::streamsize origPrecision = out.precision();
+    std::ios::fmtflags origFlags = out.flags();
+    char origFill = out.fill();
+    bool spacePadPositive = false;
+    int ntrunc = -1;
+    int argIndex = 0;
+    const char* specEnd = streamStateFromFormat(out, spacePadPositive, ntrunc,
+                                                elemSpec, 0, argIndex, 0);
+    if(*specEnd != '\0')
+    {
+        TINYFORMAT_ERROR("tinyformat: Join element spec must be a single conversion");
+    }
+    else
+    {
+        // The width is reset by each output operation, so must be restored
+        // for each element.
+        std::streamsize width = out.width();
+        size_t sepLen = std::strlen(sep);
+        for(Iterator i = begin; i != end; ++i)
+        {
+            if(i != begin)
+                out.write(sep, static_cast<std::streamsize>(sepLen));
+            out.width(width);
+            formatArgument(out, FormatArg(*i), elemSpec, specEnd, ntrunc,
+                           spacePadPositive);
+        }
+    }
+    out.width(origWidth);
+    out.precision(origPrecision);
+    out.flags(origFlags);
+    out.fill(origFill);
+}
 
-// Format list subclass with fixed storage to avoid dynamic allocation
-template<int N>
-class FormatListN : public FormatList
+// Translate the std::format style replacement field spec starting at c (just
+// after the '{' and any argument index) into the equivalent printf spec in
+// spec, which has room for specSize characters.  The fill character and
+// alignment, which printf can't express, are returned separately.  Returns a
+// pointer to the closing '}', or null if the spec is malformed.
+inline const char* braceSpecToPrintf(const char* c, char* spec, int specSize,
+                                     bool leftByDefault, char& fill, char& align)
 {
-    public:
+    char* s = spec;
+    char* specEnd = spec + specSize - 2; // leave room for conversion and '\0'
+    *s++ = '%';
+    fill = ' ';
+    align = 0;
+    char conv = 's';
+    if(*c == ':')
+    {
+        ++c;
+        if(c[0] != '\0' && (c[1] == '<' || c[1] == '>' || c[1] == '^'))
+        {
+            fill = c[0];
+            align = c[1];
+            c += 2;
+        }
+        else if(*c == '<' || *c == '>' || *c == '^')
+            align = *c++;
+        if(*c == '+' || *c == ' ')
+            *s++ = *c++;
+        else if(*c == '-')
+            ++c;
+        if(*c == '#')
+            *s++ = *c++;
+        if(*c == '0')
+        {
+            // As for std::format, zero padding is ignored if an alignment
+            // is given.
+            if(!align)
+                *s++ = '0';
+            ++c;
+        }
+        if(align == '<' || (!align && leftByDefault))
+            *s++ = '-';
+        while(*c >= '0' && *c <= '9' && s < specEnd)
+            *s++ = *c++;
+        if(*c == '.')
+        {
+            *s++ = *c++;
+            while(*c >= '0' && *c <= '9' && s < specEnd)
+                *s++ = *c++;
+        }
+        if(*c != '}' && *c != '\0')
+            conv = *c++;
+    }
+    else if(leftByDefault)
+        *s++ = '-';
+    if(*c != '}' || s >= specEnd)
+        return 0;
+    *s++ = conv;
+    *s = '\0';
+    return c;
+}
+
+// Format using a std::format style format string: "{}" fields take the
+// arguments in order and "{N}" fields the argument with index N, with an
+// optional spec after a ':' of the form [[fill]align][sign][#][0][width]
+// [.precision][type].  Each field is translated into the equivalent printf
+// spec and formatted by the same machinery as formatImpl().  As for
+// std::format, strings, characters and bools are left aligned by default and
+// other values right aligned.
+inline void formatBracesImpl(std::ostream& out, const char* fmt,
+                             const detail::FormatArg* formatters,
+                             int numFormatters)
+{
+    std::streamsize origWidth = out.width();
+    std::streamsize origPrecision = out.precision();
+    std::ios::fmtflags origFlags = out.flags();
+    char origFill = out.fill();
+
+    int nextArg = 0;
+    bool autoIndex = false;
+    bool manualIndex = false;
+    for(const char* c = fmt; ; )
+    {
+        const char* lit = c;
+        while(*c != '\0' && *c != '{' && *c != '}')
+            ++c;
+        out.write(lit, c - lit);
+        if(*c == '\0')
+            break;
+        if(c[0] == c[1])
+        {
+            // "{{" or "}}" escape
+            out.put(*c);
+            c += 2;
+            continue;
+        }
+        if(*c == '}')
+        {
+            TINYFORMAT_ERROR("tinyformat: Unmatched '}' in format string");
+            break;
+        }
+        ++c;
+        int argIndex = 0;
+        if(*c >= '0' && *c <= '9')
+        {
+            manualIndex = true;
+            while(*c >= '0' && *c <= '9')
+                argIndex = 10*argIndex + (*c++ - '0');
+        }
+        else
+        {
+            autoIndex = true;
+            argIndex = nextArg++;
+        }
+        if(autoIndex && manualIndex)
+        {
+            TINYFORMAT_ERROR("tinyformat: Cannot mix automatic and manual argument indexing");
+            break;
+        }
+        if(argIndex >= numFormatters)
+        {
+            TINYFORMAT_ERROR("tinyformat: Not enough format arguments");
+            break;
+        }
+        const FormatArg& arg = formatters[argIndex];
+        int type = arg.type();
+        bool leftByDefault = arg.isString() || type == ArgChar || type == ArgBool;
+        char spec[32];
+        char fill = ' ';
+        char align = 0;
+        const char* fieldEnd = braceSpecToPrintf(c, spec, sizeof(spec),
+                                                 leftByDefault, fill, align);
+        if(!fieldEnd)
+        {
+            TINYFORMAT_ERROR("tinyformat: Invalid replacement field in format string");
+            break;
+        }
+        c = fieldEnd + 1;
+        bool spacePadPositive = false;
+        int ntrunc = -1;
+        int specArgIndex = 0;
+        const char* specEnd = streamStateFromFormat(out, spacePadPositive, ntrunc,
+                                                    spec, 0, specArgIndex, 0);
+        if(align)
+            out.fill(fill);
+        if(align != '^')
+            formatArgument(out, arg, spec, specEnd, ntrunc, spacePadPositive);
+        else
+        {
+            // Centering has no stream equivalent, so format unpadded into a
+            // temporary buffer and split the padding around the result.
+            std::streamsize width = out.width();
+            out.width(0);
+            SmallStreamBuf<256> buf;
+            std::ostream tmpStream(&buf);
+            tmpStream.copyfmt(out);
+            formatArgument(tmpStream, arg, spec, specEnd, ntrunc,
+                           spacePadPositive);
+            std::streamsize pad = width - buf.size();
+            for(std::streamsize i = 0; i < pad/2; ++i)
+                out.put(fill);
+            out.write(buf.data(), buf.size());
+            for(std::streamsize i = pad/2; i < pad; ++i)
+                out.put(fill);
+        }
+    }
+
+    out.width(origWidth);
+    out.precision(origPrecision);
+    out.flags(origFlags);
+    out.fill(origFill);
+}
+
+// Write a value which formats itself with value.format(out), ignoring the
+// stream width, as a single string: padded to the width of the outer
+// conversion and truncated to ntrunc characters.  The output is collected
+// in a temporary buffer only when it must be padded or truncated.
+template<typename T>
+void formatWholeValue(std::ostream& out, const T& value, int ntrunc)
+{
+    if(out.width() == 0 && ntrunc < 0)
+    {
+        value.format(out);
+        return;
+    }
+    SmallStreamBuf<256> buf;
+    std::ostream tmpStream(&buf);
+    tmpStream.copyfmt(out);
+    tmpStream.width(0);
+    value.format(tmpStream);
+    formatPadded(out, buf.data(), buf.size(), ntrunc);
+}
+
+} // namespace detail
+
+
+/// Wrapper for formatting a range of values with separators, as returned by
+/// join().
+template<typename Iterator>
+class JoinValue
+{
+    public:
+        JoinValue(Iterator begin, Iterator end, const char* sep,
+                  const char* elemSpec)
+            : m_begin(begin), m_end(end), m_sep(sep), m_elemSpec(elemSpec) { }
+
+        void format(std::ostream& out) const
+        {
+            detail::formatJoined(out, m_begin, m_end, m_sep, m_elemSpec);
+        }
+
+    private:
+        Iterator m_begin;
+        Iterator m_end;
+        const char* m_sep;
+        const char* m_elemSpec;
+};
+
+template<typename Iterator>
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc,
+                        const JoinValue<Iterator>& value)
+{
+    detail::formatWholeValue(out, value, ntrunc);
+}
+
+template<typename Iterator>
+inline std::ostream& operator<<(std::ostream& out, const JoinValue<Iterator>& value)
+{
+    value.format(out);
+    return out;
+}
+
+/// Format the elements of a range with sep between them, each formatted
+/// with the single conversion elemSpec:
+///
+///   tfm::printfln("ids: %s", tfm::join(ids, ", ", "%04x"));
+///   out << tfm::join(names, "|");
+///
+/// The result refers to the range, which must outlive it.  Elements are
+/// written straight to the output stream, and elemSpec is parsed once.  The
+/// width and precision of the outer conversion apply to the joined result
+/// as a whole, as for a string: "%-20.10s".
+template<typename Range>
+JoinValue<typename Range::const_iterator> join(const Range& range,
+                                               const char* sep,
+                                               const char* elemSpec = "%s")
+{
+    return JoinValue<typename Range::const_iterator>(range.begin(), range.end(),
+                                                     sep, elemSpec);
+}
+
+template<typename T, std::size_t N>
+JoinValue<const T*> join(const T (&array)[N], const char* sep,
+                         const char* elemSpec = "%s")
+{
+    return JoinValue<const T*>(array, array + N, sep, elemSpec);
+}
+
+/// Format the elements from begin to end; see join(range, sep, elemSpec).
+template<typename Iterator>
+JoinValue<Iterator> join(Iterator begin, Iterator end, const char* sep,
+                         const char* elemSpec = "%s")
+{
+    return JoinValue<Iterator>(begin, end, sep, elemSpec);
+}
+
+namespace detail {
+// Widen IEEE half precision bits to a float.  Both the normal and the
+// subnormal results are computed and one selected, with no branches, so that
+// loops over arrays can be vectorized.  Assumes 32 bit unsigned int, as does
+// the float bit layout.
+inline float halfToFloat(unsigned short h)
+{
+    const unsigned int expMask = 0x7c00u << 13;
+    unsigned int bits = (h & 0x7fffu) << 13;
+    unsigned int exp = bits & expMask;
+    bits += (127 - 15) << 23;
+    bits += exp == expMask ? (128 - 16) << 23 : 0; // Inf or NaN
+    // Zero or subnormal: renormalize via float arithmetic
+    unsigned int subnormalBits = bits + (1 << 23);
+    float f;
+    std::memcpy(&f, &subnormalBits, sizeof(f));
+    f -= 6.103515625e-05f; // 2^-14
+    std::memcpy(&subnormalBits, &f, sizeof(f));
+    unsigned int isSubnormal = 0u - static_cast<unsigned int>(exp == 0);
+    bits = (subnormalBits & isSubnormal) | (bits & ~isSubnormal);
+    bits |= static_cast<unsigned int>(h & 0x8000u) << 16;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Widen bfloat16 bits, the top half of a float, to a float.
+inline float bfloat16ToFloat(unsigned short h)
+{
+    unsigned int bits = static_cast<unsigned int>(h) << 16;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Format n 16 bit floats as for join(), widening them a block at a time so
+// that the conversion runs as a simple loop over the block.
+inline void formatFloat16Array(std::ostream& out, const unsigned short* data,
+                               size_t n, bool bfloat, const char* sep,
+                               const char* elemSpec)
+{
+    const size_t blockSize = 64;
+    float block[blockSize];
+    for(size_t i = 0; i < n; i += blockSize)
+    {
+        size_t m = std::min(blockSize, n - i);
+        if(bfloat)
+            for(size_t j = 0; j < m; ++j)
+                block[j] = bfloat16ToFloat(data[i + j]);
+        else
+            for(size_t j = 0; j < m; ++j)
+                block[j] = halfToFloat(data[i + j]);
+        if(i != 0)
+            out.write(sep, static_cast<std::streamsize>(std::strlen(sep)));
+        formatJoined(out, block + 0, block + m, sep, elemSpec);
+    }
+}
+} // namespace detail
+
+
+/// Wrapper for formatting the bits of a 16 bit floating point value, as
+/// returned by half() or bfloat16().
+class Float16Value
+{
+    public:
+        Float16Value(unsigned short bits, bool bfloat)
+            : m_bits(bits), m_bfloat(bfloat) { }
+
+        float toFloat() const
+        {
+            return m_bfloat ? detail::bfloat16ToFloat(m_bits)
+                            : detail::halfToFloat(m_bits);
+        }
+
+    private:
+        unsigned short m_bits;
+        bool m_bfloat;
+};
+
+/// Wrapper for formatting an array of 16 bit floating point values, as
+/// returned by halfArray() or bfloat16Array().
+class Float16ArrayValue
+{
+    public:
+        Float16ArrayValue(const unsigned short* data, size_t n, bool bfloat,
+                          const char* sep, const char* elemSpec)
+            : m_data(data), m_n(n), m_bfloat(bfloat), m_sep(sep),
+            m_elemSpec(elemSpec) { }
+
+        void format(std::ostream& out) const
+        {
+            detail::formatFloat16Array(out, m_data, m_n, m_bfloat, m_sep,
+                                       m_elemSpec);
+        }
+
+    private:
+        const unsigned short* m_data;
+        size_t m_n;
+        bool m_bfloat;
+        const char* m_sep;
+        const char* m_elemSpec;
+};
+
+inline void formatValue(std::ostream& out, const char* fmtBegin,
+                        const char* fmtEnd, int ntrunc, const Float16Value& value)
+{
+    formatValue(out, fmtBegin, fmtEnd, ntrunc, value.toFloat());
+}
+
+inline void formatValue(std::ostream& out, const char* /*fmtBegin*/,
+                        const char* /*fmtEnd*/, int ntrunc,
+                        const Float16ArrayValue& value)
+{
+    detail::formatWholeValue(out, value, ntrunc);
+}
+
+inline std::ostream& operator<<(std::ostream& out, const Float16ArrayValue& value)
+{
+    value.format(out);
+    return out;
+}
+
+/// Format the bits of an IEEE half precision (binary16) value as the
+/// corresponding float.
+inline Float16Value half(unsigned short bits)
+{
+    return Float16Value(bits, false);
+}
+
+/// Format the bits of a bfloat16 value as the corresponding float.
+inline Float16Value bfloat16(unsigned short bits)
+{
+    return Float16Value(bits, true);
+}
+
+/// Format an array of n half precision values with sep between them, each
+/// formatted as a float with the single conversion elemSpec, as for join():
+///
+///   tfm::format(out, "[%s]\n", tfm::halfArray(tensor, n, ", ", "%.4g"));
+///
+/// The values are widened to float in blocks and the spec is parsed once for
+/// each block.  As for join(), the width and precision of the outer
+/// conversion apply to the result as a whole.
+inline Float16ArrayValue halfArray(const unsigned short* data, size_t n,
+                                   const char* sep, const char* elemSpec = "%s")
+{
+    return Float16ArrayValue(data, n, false, sep, elemSpec);
+}
+
+/// Format an array of n bfloat16 values; see halfArray().
+inline Float16ArrayValue bfloat16Array(const unsigned short* data, size_t n,
+                                       const char* sep, const char* elemSpec = "%s")
+{
+    return Float16ArrayValue(data, n, true, sep, elemSpec);
+}
+
+
+namespace detail {
+
+
+//------------------------------------------------------------------------------
+// Structured output: key=value (logfmt) and JSON records.
+
+// Return the position of the next nontrivial format spec in fmt, or the end
+// of the string.  Like printFormatStringLiteral() but without any output.
+inline const char* findFormatSpec(const char* fmt)
+{
+    for(;; ++fmt)
+    {
+        if(*fmt == '\0')
+            return fmt;
+        if(*fmt == '%')
+        {
+            if(*(fmt+1) != '%')
+                return fmt;
+            ++fmt;
+        }
+    }
+}
+
+// Find the field name for a format spec starting at spec, which is the run of
+// identifier characters immediately before an '=' preceding the spec, for
+// example "user" in "login user=%s".  The name must lie within [begin, spec).
+// Returns false if there is no such name.
+inline bool fieldNameBefore(const char* begin, const char* spec,
+                            const char*& nameBegin, const char*& nameEnd)
+{
+    if(spec == begin || *(spec-1) != '=')
+        return false;
+    nameEnd = spec - 1;
+    nameBegin = nameEnd;
+    while(nameBegin > begin)
+    {
+        char c = *(nameBegin-1);
+        if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+             (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-'))
+            break;
+        --nameBegin;
+    }
+    return nameBegin != nameEnd;
+}
+
+// Test whether [s, s+len) is a number according to the JSON grammar.
+inline bool isJsonNumber(const char* s, std::streamsize len)
+{
+    const char* end = s + len;
+    if(s != end && *s == '-')
+        ++s;
+    if(s == end || *s < '0' || *s > '9')
+        return false;
+    if(*s == '0' && s+1 != end && *(s+1) >= '0' && *(s+1) <= '9')
+        return false; // no leading zeros
+    while(s != end && *s >= '0' && *s <= '9')
+        ++s;
+    if(s != end && *s == '.')
+    {
+        if(++s == end || *s < '0' || *s > '9')
+            return false;
+        while(s != end && *s >= '0' && *s <= '9')
+            ++s;
+    }
+    if(s != end && (*s == 'e' || *s == 'E'))
+    {
+        ++s;
+        if(s != end && (*s == '+' || *s == '-'))
+            ++s;
+        if(s == end || *s < '0' || *s > '9')
+            return false;
+        while(s != end && *s >= '0' && *s <= '9')
+            ++s;
+    }
+    return s == end;
+}
+
+// Write [s, s+len) as the body of a double quoted string, escaping quotes,
+// backslashes and control characters as for JSON.  Runs of characters which
+// need no escaping are written with a single call.
+inline void writeEscaped(std::ostream& out, const char* s, std::streamsize len)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    const char* run = s;
+    const char* end = s + len;
+    for(; s != end; ++s)
+    {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if(c >= 0x20 && c != '"' && c != '\\' && c != 0x7f)
+            continue;
+        out.write(run, s - run);
+        run = s + 1;
+        char esc[6] = {'\\', 0, 0, 0, 0, 0};
+        int escLen = 2;
+        switch(c)
+        {
+            case '"':  esc[1] = '"';  break;
+            case '\\': esc[1] = '\\'; break;
+            case '\n': esc[1] = 'n';  break;
+            case '\r': esc[1] = 'r';  break;
+            case '\t': esc[1] = 't';  break;
+            default:
+                esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+                esc[4] = hexDigits[c >> 4]; esc[5] = hexDigits[c & 0xf];
+                escLen = 6;
+                break;
+        }
+        out.write(esc, escLen);
+    }
+    out.write(run, end - run);
+}
+
+// Stream buffer which escapes everything written to it with writeEscaped()
+// and passes the result on to another stream, so that values of any length
+// can be escaped without first collecting them.
+class EscapingStreamBuf : public std::streambuf
+{
+    public:
+        explicit EscapingStreamBuf(std::ostream& out) : m_out(out) { }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if(traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
+            char ch = traits_type::to_char_type(c);
+            writeEscaped(m_out, &ch, 1);
+            return c;
+        }
+
+        virtual std::streamsize xsputn(const char* s, std::streamsize n)
+        {
+            writeEscaped(m_out, s, n);
+            return n;
+        }
+
+    private:
+        std::ostream& m_out;
+};
+
+// Write a formatted value as a logfmt value: values containing spaces, '=',
+// quotes or control characters are quoted and escaped, others are written
+// as they are.
+inline void writeKeyValueValue(std::ostream& out, const char* s, std::streamsize len)
+{
+    bool needQuotes = len == 0;
+    for(std::streamsize i = 0; i < len && !needQuotes; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        needQuotes = c <= ' ' || c == '=' || c == '"' || c == '\\' || c == 0x7f;
+    }
+    if(!needQuotes)
+    {
+        out.write(s, len);
+        return;
+    }
+    out.put('"');
+    writeEscaped(out, s, len);
+    out.put('"');
+}
+
+// Format arguments as a structured record.  In key=value mode the format
+// string is copied as usual but each formatted value is quoted and escaped
+// as necessary.  In JSON mode one object member is written per argument,
+// named after the field name preceding the format spec (or "argN" if there
+// is none); the remaining literal text of the format string is not output.
+// Each value is formatted once into a small stack buffer, then escaped
+// directly into the output.  With TINYFORMAT_NO_HEAP, a value too long for
+// the buffer is instead quoted and formatted a second time straight through
+// an EscapingStreamBuf.
+inline void formatStructuredImpl(std::ostream& out, const char* fmt,
+                                 const detail::FormatArg* formatters,
+                                 int numFormatters, bool json)
+{
+    SmallStreamBuf<128> valueBuf;
+    std::ostream valueStream(&valueBuf);
+    valueStream.copyfmt(out);
+    if(json)
+        out.put('{');
+    for (int argIndex = 0, field = 0; argIndex < numFormatters; ++argIndex, ++field)
+    {
+        const char* spec = json ? findFormatSpec(fmt) : printFormatStringLiteral(out, fmt);
+        if(json)
+        {
+            if(field != 0)
+                out.put(',');
+            out.put('"');
+            const char* nameBegin = 0;
+            const char* nameEnd = 0;
+            if(fieldNameBefore(fmt, spec, nameBegin, nameEnd))
+                writeEscaped(out, nameBegin, nameEnd - nameBegin);
+            else
+            {
+                char name[16] = "arg";
+                out.write(name, writeDecimal(name + 3, field) - name);
+            }
+            out.write("\":", 2);
+        }
+        valueBuf.clear();
+        bool spacePadPositive = false;
+        int ntrunc = -1;
+        int specArgIndex = argIndex;
+        const char* fmtEnd = streamStateFromFormat(valueStream, spacePadPositive, ntrunc,
+                                                   spec, formatters, argIndex, numFormatters);
+        if (argIndex >= numFormatters)
+        {
+            TINYFORMAT_ERROR("tinyformat: Not enough format arguments");
+            return;
+        }
+        formatArgument(valueStream, formatters[argIndex], spec, fmtEnd, ntrunc,
+                       spacePadPositive);
+        const char* value = valueBuf.data();
+        std::streamsize valueLen = valueBuf.size();
+        if(!valueStream)
+        {
+            // Output was discarded by the fixed size buffer
+            valueStream.clear();
+            out.put('"');
+            EscapingStreamBuf escapeBuf(out);
+            std::ostream escapeStream(&escapeBuf);
+            escapeStream.copyfmt(out);
+            streamStateFromFormat(escapeStream, spacePadPositive, ntrunc, spec,
+                                  formatters, specArgIndex, numFormatters);
+            formatArgument(escapeStream, formatters[argIndex], spec, fmtEnd,
+                           ntrunc, spacePadPositive);
+            out.put('"');
+        }
+        else if(!json)
+            writeKeyValueValue(out, value, valueLen);
+        else if(std::strchr("diueEfFgG", *(fmtEnd-1)) && isJsonNumber(value, valueLen))
+            out.write(value, valueLen);
+        else
+        {
+            out.put('"');
+            writeEscaped(out, value, valueLen);
+            out.put('"');
+        }
+        fmt = fmtEnd;
+    }
+    fmt = json ? findFormatSpec(fmt) : printFormatStringLiteral(out, fmt);
+    if(*fmt != '\0')
+        TINYFORMAT_ERROR("tinyformat: Too many conversion specifiers in format string");
+    if(json)
+        out.put('}');
+}
+
+// Writes the fields of an aggregate registered with TINYFORMAT_FORMAT_FIELDS
+// as {name=value, ...}.  Each field is formatted with the conversion spec
+// given for the aggregate as a whole, so "%.2f" applies to every field; the
+// width is restored for each field as for join().  String fields are quoted
+// and escaped as they are written, so they may have any length.
+class FieldWriter
+{
+    public:
+        FieldWriter(std::ostream& out, const char* fmtBegin,
+                    const char* fmtEnd, int ntrunc)
+            : m_out(out), m_fmtBegin(fmtBegin), m_fmtEnd(fmtEnd),
+            m_ntrunc(ntrunc), m_width(out.width()), m_first(true)
+        {
+            out.width(0);
+            out.put('{');
+        }
+
+        // Write the closing brace.  This isn't done by a destructor, which
+        // would also write it while unwinding from an exception.
+        void finish()
+        {
+            m_out.put('}');
+        }
+
+        template<typename T>
+        void field(const char* name, const T& value)
+        {
+            if(!m_first)
+                m_out.write(", ", 2);
+            m_first = false;
+            m_out.write(name, static_cast<std::streamsize>(std::strlen(name)));
+            m_out.put('=');
+            FormatArg arg(value);
+            int type = arg.type();
+            if(type != ArgCString && type != ArgCharArray && type != ArgStdString)
+            {
+                m_out.width(m_width);
+                arg.format(m_out, m_fmtBegin, m_fmtEnd, m_ntrunc);
+                return;
+            }
+            m_out.put('"');
+            EscapingStreamBuf escapeBuf(m_out);
+            std::ostream escapeStream(&escapeBuf);
+            escapeStream.copyfmt(m_out);
+            escapeStream.width(m_width);
+            arg.format(escapeStream, m_fmtBegin, m_fmtEnd, m_ntrunc);
+            m_out.put('"');
+        }
+
+    private:
+        std::ostream& m_out;
+        const char* m_fmtBegin;
+        const char* m_fmtEnd;
+        int m_ntrunc;
+        std::streamsize m_width;
+        bool m_first;
+};
+
+} // namespace detail
+
+
+/// Define formatValue() for an aggregate type so that it is formatted field
+/// by field, for example
+///
+///   struct Order { int id; std::string symbol; double price; };
+///   TINYFORMAT_FORMAT_FIELDS(Order, (id)(symbol)(price))
+///
+/// makes tfm::format("%s", order) give {id=1, symbol="ABC", price=9.5}.  The
+/// macro must be used at namespace scope in the namespace of the type, so
+/// that the overload is found by argument dependent lookup.  Registered types
+/// may be nested as fields of other registered types.
+#define TINYFORMAT_FORMAT_FIELDS(type, fields)                             \
+inline void formatValue(std::ostream& out, const char* fmtBegin,           \
+                        const char* fmtEnd, int ntrunc, const type& value) \
+{                                                                          \
+    ::tinyformat::detail::FieldWriter writer(out, fmtBegin, fmtEnd, ntrunc); \
+    TINYFORMAT_FIELDS_CAT(TINYFORMAT_FIELDS_A fields, _END)                \
+    writer.finish();                                                       \
+    (void) value;                                                          \
+}
+
+// Expand a sequence (a)(b)(c) into one call to writer.field() per element by
+// alternating between two macros, each of which leaves the name of the other
+// to consume the next element.  The trailing name is pasted with _END to
+// give an empty macro.
+#define TINYFORMAT_FIELDS_A(f) writer.field(#f, value.f); TINYFORMAT_FIELDS_B
+#define TINYFORMAT_FIELDS_B(f) writer.field(#f, value.f); TINYFORMAT_FIELDS_A
+#define TINYFORMAT_FIELDS_A_END
+#define TINYFORMAT_FIELDS_B_END
+#define TINYFORMAT_FIELDS_CAT(a, b) TINYFORMAT_FIELDS_CAT_I(a, b)
+#define TINYFORMAT_FIELDS_CAT_I(a, b) a ## b
+
+
+/// List of template arguments format(), held in a type-opaque way.
+///
+/// A const reference to FormatList (typedef'd as FormatListRef) may be
+/// conveniently used to pass arguments to non-template functions: All type
+/// information has been stripped from the arguments, leaving just enough of a
+/// common interface to perform formatting as required.
+class FormatList
+{
+    public:
+        FormatList(detail::FormatArg* formatters, int N)
+            : m_formatters(formatters), m_N(N) { }
+
+#ifdef TINYFORMAT_STREAM_API
+        friend void vformat(std::ostream& out, const char* fmt,
+                            const FormatList& list);
+        friend void vformatBraces(std::ostream& out, const char* fmt,
+                                  const FormatList& list);
+        friend void vcatTo(std::ostream& out, const FormatList& list);
+        friend void vformatKeyValue(std::ostream& out, const char* fmt,
+                                    const FormatList& list);
+        friend void vformatJson(std::ostream& out, const char* fmt,
+                                const FormatList& list);
+#endif
+#ifndef TINYFORMAT_NO_HEAP
+        friend std::string vcat(const FormatList& list);
+#endif
+
+        /// Number of arguments, and access to each of them
+        int size() const { return m_N; }
+        const detail::FormatArg& arg(int i) const { return m_formatters[i]; }
+
+    private:
+        const detail::FormatArg* m_formatters;
+        int m_N;
+};
+
+/// Reference to type-opaque format list for passing to vformat()
+typedef const FormatList& FormatListRef;
+
+
+namespace detail {
+
+// Format list of arguments to the stream, as for vformat().  Used by the
+// fixed buffer formatters, which remain available when vformat() isn't.
+inline void formatList(std::ostream& out, const char* fmt, FormatListRef list)
+{
+    formatImpl(out, fmt, list.size() ? &list.arg(0) : 0, list.size());
+}
+
+// Format list subclass with fixed storage to avoid dynamic allocation
+template<int N>
+class FormatListN : public FormatList
+{
+    public:
 #ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
         template<typename... Args>
         FormatListN(const Args&... args)
@@ -883,6 +2900,21 @@ class FormatListN : public FormatList
 #       undef TINYFORMAT_MAKE_FORMATLIST_CONSTRUCTOR
 #endif
 
+        // Copies must refer to their own storage
+        FormatListN(const FormatListN& other)
+            : FormatList(&m_formatterStore[0], N)
+        {
+            std::copy(other.m_formatterStore, other.m_formatterStore + N,
+                      m_formatterStore);
+        }
+
+        FormatListN& operator=(const FormatListN& other)
+        {
+            std::copy(other.m_formatterStore, other.m_formatterStore + N,
+                      m_formatterStore);
+            return *this;
+        }
+
     private:
         FormatArg m_formatterStore[N];
 };
@@ -893,6 +2925,50 @@ template<> class FormatListN<0> : public FormatList
     public: FormatListN() : FormatList(0, 0) {}
 };
 
+
+// Proxy for a format string and arguments, returned by lazy()
+template<int N>
+class LazyFormat
+{
+    public:
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        template<typename... Args>
+        LazyFormat(const char* fmt, const Args&... args)
+            : m_fmt(fmt), m_list(args...)
+        { }
+#else // C++98 version
+        LazyFormat(const char* fmt) : m_fmt(fmt) { }
+#       define TINYFORMAT_MAKE_LAZYFORMAT_CONSTRUCTOR(n)       \
+        template<TINYFORMAT_ARGTYPES(n)>                       \
+        LazyFormat(const char* fmt, TINYFORMAT_VARARGS(n))     \
+            : m_fmt(fmt), m_list(TINYFORMAT_PASSARGS(n))       \
+        { }
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_LAZYFORMAT_CONSTRUCTOR)
+#       undef TINYFORMAT_MAKE_LAZYFORMAT_CONSTRUCTOR
+#endif
+
+#ifndef TINYFORMAT_NO_HEAP
+        std::string str() const
+        {
+            std::ostringstream oss;
+            oss << *this;
+            return oss.str();
+        }
+
+        operator std::string() const { return str(); }
+#endif
+
+        friend std::ostream& operator<<(std::ostream& out, const LazyFormat& f)
+        {
+            formatList(out, f.m_fmt, f.m_list);
+            return out;
+        }
+
+    private:
+        const char* m_fmt;
+        FormatListN<N> m_list;
+};
+
 } // namespace detail
 
 
@@ -930,6 +3006,7 @@ TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_MAKEFORMATLIST)
 
 #endif
 
+#ifdef TINYFORMAT_STREAM_API
 /// Format list of arguments to the stream according to the given format string.
 ///
 /// The name vformat() is chosen for the semantic similarity to vprintf(): the
@@ -939,16 +3016,87 @@ inline void vformat(std::ostream& out, const char* fmt, FormatListRef list)
     detail::formatImpl(out, fmt, list.m_formatters, list.m_N);
 }
 
+/// Format list of arguments to the stream according to a std::format style
+/// format string, with "{}" or "{N}" replacement fields in place of printf
+/// specs.  Field specs such as "{:>8.3f}" are translated to the equivalent
+/// printf spec, so both styles share one formatting engine.
+inline void vformatBraces(std::ostream& out, const char* fmt, FormatListRef list)
+{
+    detail::formatBracesImpl(out, fmt, list.m_formatters, list.m_N);
+}
+
+/// Write each argument in the list to the stream as for "%s", without a
+/// format string.
+inline void vcatTo(std::ostream& out, FormatListRef list)
+{
+    detail::catImpl(out, list.m_formatters, list.m_N);
+}
+#endif
+
+#ifndef TINYFORMAT_NO_HEAP
+/// Concatenate the arguments in the list into a string.  The result is
+/// collected in a stack buffer first, so when it has at most 256 characters
+/// the returned string is the only allocation.
+inline std::string vcat(FormatListRef list)
+{
+    detail::SmallStreamBuf<256> buf;
+    std::ostream out(&buf);
+    detail::catImpl(out, list.m_formatters, list.m_N);
+    return std::string(buf.data(), static_cast<size_t>(buf.size()));
+}
+#endif
+
+/// Format list of arguments into a fixed size buffer; see formatToBuffer().
+inline size_t vformatToBuffer(char* buf, size_t bufSize, const char* fmt,
+                              FormatListRef list)
+{
+    std::streamsize capacity = bufSize ? static_cast<std::streamsize>(bufSize) - 1 : 0;
+    detail::ArrayStreamBuf sbuf(buf, capacity);
+    std::ostream out(&sbuf);
+    detail::formatList(out, fmt, list);
+    if(bufSize)
+        buf[std::min(static_cast<size_t>(sbuf.length()), bufSize - 1)] = '\0';
+    return static_cast<size_t>(sbuf.length());
+}
+
+#ifdef TINYFORMAT_STREAM_API
+/// Format list of arguments to the stream as a key=value (logfmt) record.
+///
+/// The format string is written as for vformat(), but each formatted value is
+/// quoted and escaped if it contains spaces, '=', quotes or control
+/// characters, so that "user=%s latency_ms=%d" always yields a record which
+/// can be parsed back into fields.
+inline void vformatKeyValue(std::ostream& out, const char* fmt, FormatListRef list)
+{
+    detail::formatStructuredImpl(out, fmt, list.m_formatters, list.m_N, false);
+}
+
+/// Format list of arguments to the stream as a JSON object.
+///
+/// Member names are taken from the text preceding each format spec: the
+/// format "user=%s latency_ms=%d" gives {"user":"...","latency_ms":12}.
+/// Values from numeric conversions are written as JSON numbers where
+/// possible and all other values as escaped JSON strings.  Other literal text
+/// in the format string is omitted.
+inline void vformatJson(std::ostream& out, const char* fmt, FormatListRef list)
+{
+    detail::formatStructuredImpl(out, fmt, list.m_formatters, list.m_N, true);
+}
+#endif
+
 
 #ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
 
+#ifdef TINYFORMAT_STREAM_API
 /// Format list of arguments to the stream according to given format string.
 template<typename... Args>
 void format(std::ostream& out, const char* fmt, const Args&... args)
 {
     vformat(out, fmt, makeFormatList(args...));
 }
+#endif
 
+#ifndef TINYFORMAT_NO_HEAP
 /// Format list of arguments according to the given format string and return
 /// the result as a string.
 template<typename... Args>
@@ -958,7 +3106,82 @@ std::string format(const char* fmt, const Args&... args)
     format(oss, fmt, args...);
     return oss.str();
 }
+#endif
 
+#ifdef TINYFORMAT_STREAM_API
+/// Format list of arguments to the stream according to a brace style format
+/// string; see vformatBraces().
+template<typename... Args>
+void formatBraces(std::ostream& out, const char* fmt, const Args&... args)
+{
+    vformatBraces(out, fmt, makeFormatList(args...));
+}
+#endif
+
+#ifndef TINYFORMAT_NO_HEAP
+/// Format list of arguments according to a brace style format string and
+/// return the result as a string:
+///
+///   std::string s = tfm::formatBraces("{} took {:.3f}s", name, t);
+template<typename... Args>
+std::string formatBraces(const char* fmt, const Args&... args)
+{
+    std::ostringstream oss;
+    formatBraces(oss, fmt, args...);
+    return oss.str();
+}
+#endif
+
+/// Format list of arguments into buf, which has space for bufSize
+/// characters, as for snprintf().  The output is truncated if necessary and
+/// always null terminated.  Returns the length of the complete output,
+/// excluding the null terminator.
+template<typename... Args>
+size_t formatToBuffer(char* buf, size_t bufSize, const char* fmt,
+                      const Args&... args)
+{
+    return vformatToBuffer(buf, bufSize, fmt, makeFormatList(args...));
+}
+
+#ifdef TINYFORMAT_STREAM_API
+/// Concatenate the arguments, each formatted as for "%s", onto the stream.
+/// Equivalent to format() with a format string of "%s" for each argument,
+/// but without parsing one.
+template<typename... Args>
+void catTo(std::ostream& out, const Args&... args)
+{
+    vcatTo(out, makeFormatList(args...));
+}
+#endif
+
+#ifndef TINYFORMAT_NO_HEAP
+/// Concatenate the arguments, each formatted as for "%s", into a string:
+///
+///   std::string addr = tfm::cat(host, ':', port);
+template<typename... Args>
+std::string cat(const Args&... args)
+{
+    return vcat(makeFormatList(args...));
+}
+#endif
+
+#ifdef TINYFORMAT_STREAM_API
+/// Return a proxy which formats the arguments when written to a stream with
+/// operator<<, avoiding the temporary string of format():
+///
+///   out << "result: " << tfm::lazy("%.3f", x) << '\n';
+///
+/// The proxy refers to the arguments, so it must be used before they go out
+/// of scope, normally within the same expression.  It converts to
+/// std::string when a string is required.
+template<typename... Args>
+detail::LazyFormat<sizeof...(Args)> lazy(const char* fmt, const Args&... args)
+{
+    return detail::LazyFormat<sizeof...(Args)>(fmt, args...);
+}
+#endif
+
+#ifndef TINYFORMAT_NO_HEAP
 /// Format list of arguments to std::cout, according to the given format string
 template<typename... Args>
 void printf(const char* fmt, const Args&... args)
@@ -972,15 +3195,115 @@ void printfln(const char* fmt, const Args&... args)
     format(std::cout, fmt, args...);
     std::cout << '\n';
 }
+#endif
+
+#ifdef TINYFORMAT_STREAM_API
+/// Format list of arguments to the stream as a key=value record; see
+/// vformatKeyValue().
+template<typename... Args>
+void formatKeyValue(std::ostream& out, const char* fmt, const Args&... args)
+{
+    vformatKeyValue(out, fmt, makeFormatList(args...));
+}
+
+/// Format list of arguments to the stream as a JSON object; see vformatJson().
+template<typename... Args>
+void formatJson(std::ostream& out, const char* fmt, const Args&... args)
+{
+    vformatJson(out, fmt, makeFormatList(args...));
+}
+#endif
 
 
 #else // C++98 version
 
+inline size_t formatToBuffer(char* buf, size_t bufSize, const char* fmt)
+{
+    return vformatToBuffer(buf, bufSize, fmt, makeFormatList());
+}
+
+#define TINYFORMAT_MAKE_FORMAT_FUNCS(n)                                   \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+size_t formatToBuffer(char* buf, size_t bufSize, const char* fmt,         \
+                      TINYFORMAT_VARARGS(n))                              \
+{                                                                         \
+    return vformatToBuffer(buf, bufSize, fmt,                             \
+                           makeFormatList(TINYFORMAT_PASSARGS(n)));       \
+}
+TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_FORMAT_FUNCS)
+#undef TINYFORMAT_MAKE_FORMAT_FUNCS
+
+#ifdef TINYFORMAT_STREAM_API
 inline void format(std::ostream& out, const char* fmt)
 {
     vformat(out, fmt, makeFormatList());
 }
 
+inline void formatBraces(std::ostream& out, const char* fmt)
+{
+    vformatBraces(out, fmt, makeFormatList());
+}
+
+inline detail::LazyFormat<0> lazy(const char* fmt)
+{
+    return detail::LazyFormat<0>(fmt);
+}
+
+inline void catTo(std::ostream& /*out*/) { }
+
+inline void formatKeyValue(std::ostream& out, const char* fmt)
+{
+    vformatKeyValue(out, fmt, makeFormatList());
+}
+
+inline void formatJson(std::ostream& out, const char* fmt)
+{
+    vformatJson(out, fmt, makeFormatList());
+}
+
+#define TINYFORMAT_MAKE_STREAM_FORMAT_FUNCS(n)                            \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+void format(std::ostream& out, const char* fmt, TINYFORMAT_VARARGS(n))    \
+{                                                                         \
+    vformat(out, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));            \
+}                                                                         \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+void formatBraces(std::ostream& out, const char* fmt, TINYFORMAT_VARARGS(n)) \
+{                                                                         \
+    vformatBraces(out, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));      \
+}                                                                         \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+detail::LazyFormat<n> lazy(const char* fmt, TINYFORMAT_VARARGS(n))        \
+{                                                                         \
+    return detail::LazyFormat<n>(fmt, TINYFORMAT_PASSARGS(n));            \
+}                                                                         \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+void catTo(std::ostream& out, TINYFORMAT_VARARGS(n))                      \
+{                                                                         \
+    vcatTo(out, makeFormatList(TINYFORMAT_PASSARGS(n)));                  \
+}                                                                         \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+void formatKeyValue(std::ostream& out, const char* fmt, TINYFORMAT_VARARGS(n)) \
+{                                                                         \
+    vformatKeyValue(out, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));    \
+}                                                                         \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+void formatJson(std::ostream& out, const char* fmt, TINYFORMAT_VARARGS(n)) \
+{                                                                         \
+    vformatJson(out, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));        \
+}
+
+TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_STREAM_FORMAT_FUNCS)
+#undef TINYFORMAT_MAKE_STREAM_FORMAT_FUNCS
+#endif
+
+#ifndef TINYFORMAT_NO_HEAP
 inline std::string format(const char* fmt)
 {
     std::ostringstream oss;
@@ -988,6 +3311,15 @@ inline std::string format(const char* fmt)
     return oss.str();
 }
 
+inline std::string formatBraces(const char* fmt)
+{
+    std::ostringstream oss;
+    formatBraces(oss, fmt);
+    return oss.str();
+}
+
+inline std::string cat() { return std::string(); }
+
 inline void printf(const char* fmt)
 {
     format(std::cout, fmt);
@@ -999,23 +3331,30 @@ inline void printfln(const char* fmt)
     std::cout << '\n';
 }
 
-#define TINYFORMAT_MAKE_FORMAT_FUNCS(n)                                   \
-                                                                          \
+#define TINYFORMAT_MAKE_ALLOCATING_FORMAT_FUNCS(n)                        \
 template<TINYFORMAT_ARGTYPES(n)>                                          \
-void format(std::ostream& out, const char* fmt, TINYFORMAT_VARARGS(n))    \
+std::string format(const char* fmt, TINYFORMAT_VARARGS(n))                \
 {                                                                         \
-    vformat(out, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));            \
+    std::ostringstream oss;                                               \
+    format(oss, fmt, TINYFORMAT_PASSARGS(n));                             \
+    return oss.str();                                                     \
 }                                                                         \
                                                                           \
 template<TINYFORMAT_ARGTYPES(n)>                                          \
-std::string format(const char* fmt, TINYFORMAT_VARARGS(n))                \
+std::string formatBraces(const char* fmt, TINYFORMAT_VARARGS(n))          \
 {                                                                         \
     std::ostringstream oss;                                               \
-    format(oss, fmt, TINYFORMAT_PASSARGS(n));                             \
+    formatBraces(oss, fmt, TINYFORMAT_PASSARGS(n));                       \
     return oss.str();                                                     \
 }                                                                         \
                                                                           \
 template<TINYFORMAT_ARGTYPES(n)>                                          \
+std::string cat(TINYFORMAT_VARARGS(n))                                    \
+{                                                                         \
+    return vcat(makeFormatList(TINYFORMAT_PASSARGS(n)));                  \
+}                                                                         \
+                                                                          \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
 void printf(const char* fmt, TINYFORMAT_VARARGS(n))                       \
 {                                                                         \
     format(std::cout, fmt, TINYFORMAT_PASSARGS(n));                       \
@@ -1027,13 +3366,17 @@ void printfln(const char* fmt, TINYFORMAT_VARARGS(n))                     \
     format(std::cout, fmt, TINYFORMAT_PASSARGS(n));                       \
     std::cout << '\n';                                                    \
 }
-
-TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_FORMAT_FUNCS)
-#undef TINYFORMAT_MAKE_FORMAT_FUNCS
+TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_ALLOCATING_FORMAT_FUNCS)
+#undef TINYFORMAT_MAKE_ALLOCATING_FORMAT_FUNCS
+#endif
 
 #endif
 
 
 } // namespace tinyformat
 
+#ifdef TINYFORMAT_SUPPRESS_LONG_LONG_WARNINGS
+#   pragma GCC diagnostic pop
+#endif
+
 #endif // TINYFORMAT_H_INCLUDED
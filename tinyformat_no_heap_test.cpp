@@ -0,0 +1,161 @@
+// Tests of the strict TINYFORMAT_NO_HEAP mode, in which only the functions
+// formatting into fixed size buffers are available.  operator new is
+// replaced to count allocations, and each test fails if any is made.
+
+#include <cstdlib>
+#include <new>
+
+#ifndef TINYFORMAT_NO_HEAP
+#   define TINYFORMAT_NO_HEAP
+#endif
+
+#include "tinyformat.h"
+#include "tinyformat_sinks.h"
+
+#ifdef TINYFORMAT_STREAM_API
+#   error "Stream functions must not be available with TINYFORMAT_NO_HEAP"
+#endif
+
+static long g_allocations = 0;
+
+#if __cplusplus < 201103L
+#   define TEST_THROW_BAD_ALLOC throw(std::bad_alloc)
+#   define TEST_NOEXCEPT throw()
+#else
+#   define TEST_THROW_BAD_ALLOC
+#   define TEST_NOEXCEPT noexcept
+#endif
+
+void* operator new(std::size_t size) TEST_THROW_BAD_ALLOC
+{
+    ++g_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) TEST_THROW_BAD_ALLOC
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) TEST_NOEXCEPT
+{
+    ++g_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) TEST_NOEXCEPT
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) TEST_NOEXCEPT { std::free(p); }
+void operator delete[](void* p) TEST_NOEXCEPT { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) TEST_NOEXCEPT { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) TEST_NOEXCEPT { std::free(p); }
+
+
+#define CHECK_EQUAL(a, b)                                  \
+if(!((a) == (b)))                                          \
+{                                                          \
+    std::cout << "test failed, line " << __LINE__ << "\n"; \
+    std::cout << (a) << " != " << (b) << "\n";             \
+    std::cout << "[" #a ", " #b "]\n";                     \
+    ++nfailed;                                             \
+}
+
+// Check that no allocation was made since the start of the test block
+#define CHECK_NO_ALLOCATIONS()                                          \
+if(g_allocations != allocationsBefore)                                  \
+{                                                                       \
+    std::cout << "test failed, line " << __LINE__ << "\n";              \
+    std::cout << g_allocations - allocationsBefore << " allocations\n"; \
+    ++nfailed;                                                          \
+}
+
+
+int unitTests()
+{
+    int nfailed = 0;
+
+#ifdef TEST_NO_HEAP_STRING_COMPILE
+    // Allocates a string - should fail to compile!
+    tfm::format("%d", 1);
+#endif
+#ifdef TEST_NO_HEAP_STREAM_COMPILE
+    // Stream output may allocate - should fail to compile!
+    tfm::format(std::cout, "%d", 1);
+#endif
+
+    // Test formatting into a fixed buffer
+    {
+        long allocationsBefore = g_allocations;
+        char buf[128];
+        int values[] = {1, 2, 3};
+        tfm::formatToBuffer(buf, sizeof(buf), "%s|%5d|%-4x|%.3f|%e|%g|%c|%b|%s|%lld",
+                            "str", 42, 255, 3.14159, 1.5, 0.25, 'z', 5, true,
+                            -9000000000LL);
+        CHECK_EQUAL(std::strcmp(buf, "str|   42|ff  |3.142|1.500000e+00|0.25|z|101|true|-9000000000"), 0);
+        tfm::formatToBuffer(buf, sizeof(buf), "[%8.2s|% d|%s|%6s]", 1234, 7,
+                            tfm::hexId(0xab), tfm::join(values, values + 3, ","));
+        CHECK_EQUAL(std::strcmp(buf, "[      12| 7|00000000000000ab| 1,2,3]"), 0);
+        CHECK_EQUAL(tfm::formatToBuffer(buf, 6, "%s", "truncated"), 9u);
+        CHECK_EQUAL(std::strcmp(buf, "trunc"), 0);
+        CHECK_NO_ALLOCATIONS();
+    }
+
+    // Test the non-materialising sinks
+    {
+        long allocationsBefore = g_allocations;
+        CHECK_EQUAL(tfm::formattedLength("%s:%d", "host", 8080), 9u);
+        CHECK_EQUAL(tfm::formatEquals("host:8080", "%s:%d", "host", 8080), true);
+        CHECK_EQUAL(tfm::formatHash("%d", 1) == tfm::formatHash("%d", 2), false);
+        CHECK_NO_ALLOCATIONS();
+    }
+
+    // Test length-prefixed frames
+    {
+        long allocationsBefore = g_allocations;
+        tfm::FrameWriter frames(tfm::FrameWriter::BigEndian16);
+        CHECK_EQUAL(frames.frame("PUT %s %d", "key", 42), true);
+        CHECK_EQUAL(frames.size(), 12u);
+        char big[2000];
+        std::memset(big, 'x', sizeof(big) - 1);
+        big[sizeof(big) - 1] = '\0';
+        CHECK_EQUAL(frames.frame("%s", big), false);
+        CHECK_EQUAL(frames.size(), 12u);
+        CHECK_NO_ALLOCATIONS();
+    }
+
+#ifdef TINYFORMAT_SINKS_POSIX
+    // Test async-signal-safe formatting
+    {
+        long allocationsBefore = g_allocations;
+        int fds[2];
+        CHECK_EQUAL(pipe(fds), 0);
+        char buf[64];
+        CHECK_EQUAL(tfm::signal_safe::dprintf(fds[1], "%s=%d", "x", 5), 3);
+        CHECK_EQUAL(read(fds[0], buf, sizeof(buf)), 3);
+#   ifdef TINYFORMAT_SINKS_CXX11
+        // Test the flight recorder
+        tfm::FlightRecorder::record("recorded %d %s", 1, "str");
+        tfm::FlightRecorder::dump(fds[1]);
+        ssize_t n = read(fds[0], buf, sizeof(buf));
+        CHECK_EQUAL(n > 0 && std::memcmp(buf + n - 17, "] recorded 1 str\n", 17) == 0, true);
+#   endif
+        close(fds[0]);
+        close(fds[1]);
+        CHECK_NO_ALLOCATIONS();
+    }
+#endif
+
+    return nfailed;
+}
+
+
+int main()
+{
+    return unitTests();
+}
@@ -0,0 +1,2911 @@
+// tinyformat_sinks.h
+// Copyright (C) 2011, Chris Foster [chris42f (at) gmail (d0t) com]
+//
+// Boost Software License - Version 1.0
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+//------------------------------------------------------------------------------
+// Tinyformat sinks: output destinations built on tinyformat
+//
+// tinyformat.h deliberately does nothing more than format onto a
+// std::ostream.  This optional companion header collects the record writers
+// which sit between tinyformat and the final destination of the text, for
+// programs which use tinyformat for logging and data export.  Each of them
+// formats directly into a reusable in-memory buffer so that a record costs
+// a single write to its destination.
+//
+// Components which need operating system facilities are only available on
+// POSIX systems.  With TINYFORMAT_NO_HEAP, only the components which work in
+// fixed size buffers are available: formatHash(), formattedLength() and
+// formatEquals() with their stream buffers, FrameWriter,
+// signal_safe::dprintf() and FlightRecorder.
+
+#ifndef TINYFORMAT_SINKS_H_INCLUDED
+#define TINYFORMAT_SINKS_H_INCLUDED
+
+#include "tinyformat.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define TINYFORMAT_SINKS_POSIX
+#   include <errno.h>
+#   include <sys/socket.h>
+#   include <sys/time.h>
+#   include <sys/un.h>
+#   include <unistd.h>
+#endif
+
+#if __cplusplus >= 201103L
+#   define TINYFORMAT_SINKS_CXX11
+#   include <atomic>
+#   include <chrono>
+#   include <cstdint>
+#endif
+
+#if defined(TINYFORMAT_SINKS_POSIX) && defined(TINYFORMAT_SINKS_CXX11) && \
+    !defined(TINYFORMAT_NO_HEAP)
+#   define TINYFORMAT_SINKS_SHM_RING
+#   include <new>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+
+// As in tinyformat.h, allow long long in C++98 under -pedantic
+#ifdef TINYFORMAT_SUPPRESS_LONG_LONG_WARNINGS
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wlong-long"
+#endif
+
+namespace tinyformat {
+
+//------------------------------------------------------------------------------
+namespace detail {
+
+// Write value as exactly two decimal digits.
+inline char* writeTwoDigits(char* p, int value)
+{
+    const char* pairs = decimalDigitPairs();
+    p[0] = pairs[2*value];
+    p[1] = pairs[2*value + 1];
+    return p + 2;
+}
+
+// Write value as exactly ndigits decimal digits, with leading zeros.
+inline char* writeFixedDecimal(char* p, unsigned long value, int ndigits)
+{
+    for(int i = ndigits - 1; i >= 0; --i, value /= 10)
+        p[i] = static_cast<char>('0' + value % 10);
+    return p + ndigits;
+}
+
+// Write the UTC date and time for the given number of seconds since the
+// epoch as "YYYY-MM-DDTHH:MM:SS", returning one past the end.  The date
+// conversion is Howard Hinnant's days-to-civil algorithm, which avoids the
+// locking and time zone handling of gmtime().
+inline char* writeUtcDateTime(char* p, long long seconds)
+{
+    long long days = seconds / 86400;
+    long secOfDay = static_cast<long>(seconds % 86400);
+    if(secOfDay < 0)
+    {
+        secOfDay += 86400;
+        --days;
+    }
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = static_cast<long>(z - era*146097);
+    long yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    long doy = doe - (365*yoe + yoe/4 - yoe/100);
+    long mp = (5*doy + 2) / 153;
+    int day = static_cast<int>(doy - (153*mp + 2)/5 + 1);
+    int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    long long year = yoe + era*400 + (month <= 2);
+    p = writeFixedDecimal(p, static_cast<unsigned long>(year), 4);
+    *p++ = '-';
+    p = writeTwoDigits(p, month);
+    *p++ = '-';
+    p = writeTwoDigits(p, day);
+    *p++ = 'T';
+    p = writeTwoDigits(p, static_cast<int>(secOfDay / 3600));
+    *p++ = ':';
+    p = writeTwoDigits(p, static_cast<int>(secOfDay / 60 % 60));
+    *p++ = ':';
+    return writeTwoDigits(p, static_cast<int>(secOfDay % 60));
+}
+
+// Stream buffer for reading back characters held in an existing array.
+class ArrayReadBuf : public std::streambuf
+{
+    public:
+        void reset(const char* s, std::streamsize n)
+        {
+            char* p = const_cast<char*>(s);
+            setg(p, p, p + n);
+        }
+};
+
+// Writes the shortest decimal representation of a double which reads back
+// as the same value.  Fifteen significant digits are enough for most values;
+// the rest need sixteen or seventeen.  Numbers are written and read back
+// with streams imbued with the classic locale, so the decimal point is
+// always '.' whatever the global C++ locale or the C LC_NUMERIC setting.
+// The streams are reused for each value.
+class ShortestDoubleWriter
+{
+    public:
+        ShortestDoubleWriter() : m_out(&m_outBuf), m_in(&m_inBuf)
+        {
+            m_out.imbue(std::locale::classic());
+            m_in.imbue(std::locale::classic());
+        }
+
+        // Write value to p, returning one past the end.  Infinities and NaN
+        // are written as +Inf, -Inf and NaN.  p must have room for 32
+        // characters.
+        char* write(char* p, double value)
+        {
+            if(value != value)
+            {
+                std::memcpy(p, "NaN", 3);
+                return p + 3;
+            }
+            if(value > 1.7976931348623157e308 || value < -1.7976931348623157e308)
+            {
+                std::memcpy(p, value > 0 ? "+Inf" : "-Inf", 4);
+                return p + 4;
+            }
+            if(value < 1e15 && value > -1e15 &&
+               value == static_cast<double>(static_cast<long long>(value)))
+            {
+                // Integral values, such as most counters, take a fast path.
+                long long i = static_cast<long long>(value);
+                if(i < 0 || (i == 0 && 1/value < 0))
+                    *p++ = '-';
+                return writeDecimal(p, static_cast<unsigned long long>(i < 0 ? -i : i));
+            }
+            for(int precision = 15; ; ++precision)
+            {
+                m_outBuf.clear();
+                m_out.precision(precision);
+                m_out << value;
+                if(precision == 17 || readBack() == value)
+                    break;
+            }
+            std::memcpy(p, m_outBuf.data(), static_cast<size_t>(m_outBuf.size()));
+            return p + m_outBuf.size();
+        }
+
+    private:
+        ShortestDoubleWriter(const ShortestDoubleWriter&);
+        ShortestDoubleWriter& operator=(const ShortestDoubleWriter&);
+
+        double readBack()
+        {
+            m_inBuf.reset(m_outBuf.data(), m_outBuf.size());
+            m_in.clear();
+            double value = 0;
+            m_in >> value;
+            return value;
+        }
+
+        SmallStreamBuf<32> m_outBuf;
+        std::ostream m_out;
+        ArrayReadBuf m_inBuf;
+        std::istream m_in;
+};
+
+// Test whether any of the eight bytes in word is equal to c.
+inline bool wordContainsByte(unsigned long long word, unsigned char c)
+{
+    const unsigned long long ones = TINYFORMAT_U64(0x01010101, 0x01010101);
+    unsigned long long v = word ^ (ones * c);
+    return ((v - ones) & ~v & TINYFORMAT_U64(0x80808080, 0x80808080)) != 0;
+}
+
+// Test whether [s, s+len) contains any of the four characters in chars.
+// Eight bytes are tested at a time, so the common case of a field with
+// nothing to escape is fast.
+inline bool containsAnyOf4(const char* s, std::streamsize len, const char chars[4])
+{
+    std::streamsize i = 0;
+    for(; i + 8 <= len; i += 8)
+    {
+        unsigned long long word;
+        std::memcpy(&word, s + i, 8);
+        if(wordContainsByte(word, chars[0]) || wordContainsByte(word, chars[1]) ||
+           wordContainsByte(word, chars[2]) || wordContainsByte(word, chars[3]))
+            return true;
+    }
+    for(; i < len; ++i)
+    {
+        if(s[i] == chars[0] || s[i] == chars[1] || s[i] == chars[2] || s[i] == chars[3])
+            return true;
+    }
+    return false;
+}
+
+// Size of the value of an argument with a built in arithmetic or pointer
+// type, or 0 for other types.
+inline int scalarArgSize(int type)
+{
+    switch(type)
+    {
+        case ArgBool:       return sizeof(bool);
+        case ArgChar:
+        case ArgSChar:
+        case ArgUChar:      return 1;
+        case ArgShort:
+        case ArgUShort:     return sizeof(short);
+        case ArgInt:
+        case ArgUInt:       return sizeof(int);
+        case ArgLong:
+        case ArgULong:      return sizeof(long);
+        case ArgLongLong:
+        case ArgULongLong:  return sizeof(long long);
+        case ArgFloat:      return sizeof(float);
+        case ArgDouble:     return sizeof(double);
+        case ArgLongDouble: return sizeof(long double);
+        case ArgPointer:    return sizeof(void*);
+        default:            return 0;
+    }
+}
+
+// Length of the string in a char array argument, up to the first null or
+// the end of the array.
+inline size_t charArrayLength(const FormatArg& arg)
+{
+    const char* str = static_cast<const char*>(arg.value());
+    const void* nul = std::memchr(str, '\0', arg.arraySize());
+    return nul ? static_cast<const char*>(nul) - str : arg.arraySize();
+}
+
+const unsigned long long fnvOffsetBasis = TINYFORMAT_U64(0xcbf29ce4, 0x84222325);
+
+// Update a 64 bit FNV-1a hash with len bytes of data
+inline unsigned long long fnv1a(unsigned long long hash, const void* data,
+                                size_t len)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < len; ++i)
+        hash = (hash ^ p[i]) * TINYFORMAT_U64(0x100, 0x1b3);
+    return hash;
+}
+
+#ifndef TINYFORMAT_NO_HEAP
+// Append the address of the format string and the raw argument values to
+// key, identifying a message without formatting it.  Returns false if an
+// argument doesn't have a built in type, or has a type like long double whose
+// object representation includes padding.
+inline bool appendMessageKey(std::string& key, const char* fmt, FormatListRef list)
+{
+    key.append(reinterpret_cast<const char*>(&fmt), sizeof(fmt));
+    for(int i = 0; i < list.size(); ++i)
+    {
+        const FormatArg& arg = list.arg(i);
+        const void* v = arg.value();
+        const char* str = 0;
+        size_t len = 0;
+        key += static_cast<char>(arg.type());
+        switch(arg.type())
+        {
+            case ArgOther:
+            case ArgLongDouble:
+                return false;
+            case ArgCString:
+                str = *static_cast<const char* const*>(v);
+                if(!str)
+                    return false;
+                len = std::strlen(str);
+                break;
+            case ArgCharArray:
+                str = static_cast<const char*>(v);
+                len = charArrayLength(arg);
+                break;
+            case ArgStdString:
+                str = static_cast<const std::string*>(v)->data();
+                len = static_cast<const std::string*>(v)->size();
+                break;
+            default:
+                key.append(static_cast<const char*>(v), scalarArgSize(arg.type()));
+                continue;
+        }
+        key.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        key.append(str, len);
+    }
+    return true;
+}
+#endif
+
+} // namespace detail
+
+
+#ifndef TINYFORMAT_NO_HEAP
+
+//------------------------------------------------------------------------------
+/// Writer for RFC 5424 syslog records.
+///
+/// A record has the form
+///
+///   <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID - MSG
+///
+/// The HOSTNAME, APP-NAME, PROCID and MSGID fields don't change between
+/// messages, so they're rendered once at construction.  For each message only
+/// the priority and timestamp are written (the date and time of day part of the
+/// timestamp is cached until the second changes) before the message body is
+/// formatted with tinyformat directly after them in the same buffer.  The
+/// complete record can then be sent to the syslog daemon with a single call.
+///
+/// Example:
+///
+///   tfm::SyslogWriter syslog(tfm::SyslogWriter::Local0, hostname, "proxy", pid);
+///   syslog.connect();  // to /dev/log
+///   syslog.log(tfm::SyslogWriter::Warning, "peer %s timed out", peer);
+class SyslogWriter
+{
+    public:
+        /// Severities, as defined in RFC 5424
+        enum Severity
+        {
+            Emergency = 0, Alert, Critical, Error, Warning, Notice,
+            Informational, Debug
+        };
+
+        /// Some common facility codes
+        enum Facility
+        {
+            Kernel = 0, User = 1, Daemon = 3, Auth = 4, Local0 = 16,
+            Local1, Local2, Local3, Local4, Local5, Local6, Local7
+        };
+
+        /// Create a writer for records with the given facility and header
+        /// fields.  Empty fields are written as the nil value "-".
+        SyslogWriter(int facility, const std::string& hostname,
+                     const std::string& appName, long procId,
+                     const std::string& msgId = std::string())
+            : m_facility(facility),
+            m_stream(&m_buf),
+            m_cachedSecond(-1),
+            m_socket(-1)
+        {
+            m_header = ' ';
+            appendField(hostname);
+            appendField(appName);
+            appendField(tfm::format("%d", procId));
+            appendField(msgId);
+            m_header += "- "; // no structured data
+        }
+
+        ~SyslogWriter()
+        {
+            disconnect();
+        }
+
+        /// Format a record into the internal buffer, timestamped with the
+        /// given number of seconds and microseconds since the epoch.
+        /// Microseconds outside [0, 1000000) are carried into the seconds.
+        void vformatRecord(int severity, long long seconds, long microseconds,
+                           const char* fmt, FormatListRef list)
+        {
+            // Start from a good stream state, even if formatting the
+            // previous record failed
+            m_buf.clear();
+            m_stream.clear();
+            if(microseconds < 0 || microseconds >= 1000000)
+            {
+                seconds += microseconds / 1000000;
+                microseconds %= 1000000;
+                if(microseconds < 0)
+                {
+                    microseconds += 1000000;
+                    --seconds;
+                }
+            }
+            char prefix[48];
+            char* p = prefix;
+            *p++ = '<';
+            p = detail::writeDecimal(p, static_cast<unsigned long>(8*m_facility + (severity & 7)));
+            *p++ = '>';
+            *p++ = '1';
+            *p++ = ' ';
+            if(seconds != m_cachedSecond)
+            {
+                detail::writeUtcDateTime(m_cachedDateTime, seconds);
+                m_cachedSecond = seconds;
+            }
+            std::memcpy(p, m_cachedDateTime, sizeof(m_cachedDateTime));
+            p += sizeof(m_cachedDateTime);
+            *p++ = '.';
+            p = detail::writeFixedDecimal(p, static_cast<unsigned long>(microseconds), 6);
+            *p++ = 'Z';
+            m_buf.sputn(prefix, p - prefix);
+            m_buf.sputn(m_header.data(), static_cast<std::streamsize>(m_header.size()));
+            vformat(m_stream, fmt, list);
+        }
+
+        /// Formatted record from the last call to vformatRecord()
+        const char* data() const { return m_buf.data(); }
+        size_t size() const { return static_cast<size_t>(m_buf.size()); }
+
+#ifdef TINYFORMAT_SINKS_POSIX
+        /// Connect to the Unix datagram socket of a local syslog daemon.
+        /// Returns false on failure.
+        bool connect(const char* path = "/dev/log")
+        {
+            disconnect();
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            if(std::strlen(path) >= sizeof(addr.sun_path))
+                return false;
+            addr.sun_family = AF_UNIX;
+            std::strcpy(addr.sun_path, path);
+            m_socket = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+            if(m_socket < 0)
+                return false;
+            if(::connect(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+            {
+                disconnect();
+                return false;
+            }
+            return true;
+        }
+
+        void disconnect()
+        {
+            if(m_socket >= 0)
+                ::close(m_socket);
+            m_socket = -1;
+        }
+
+        /// Send the formatted record to the connected socket.  Returns false
+        /// if not connected or the send fails.
+        bool send() const
+        {
+            return m_socket >= 0 &&
+                ::send(m_socket, data(), size(), 0) == static_cast<ssize_t>(size());
+        }
+
+        /// Format a record timestamped with the current time and send it.
+        bool vlog(int severity, const char* fmt, FormatListRef list)
+        {
+            timeval now;
+            ::gettimeofday(&now, 0);
+            vformatRecord(severity, now.tv_sec, now.tv_usec, fmt, list);
+            return send();
+        }
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        template<typename... Args>
+        bool log(int severity, const char* fmt, const Args&... args)
+        {
+            return vlog(severity, fmt, makeFormatList(args...));
+        }
+#else
+        bool log(int severity, const char* fmt)
+        {
+            return vlog(severity, fmt, makeFormatList());
+        }
+#       define TINYFORMAT_MAKE_SYSLOG_LOG(n)                                   \
+        template<TINYFORMAT_ARGTYPES(n)>                                       \
+        bool log(int severity, const char* fmt, TINYFORMAT_VARARGS(n))         \
+        {                                                                      \
+            return vlog(severity, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));\
+        }
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_SYSLOG_LOG)
+#       undef TINYFORMAT_MAKE_SYSLOG_LOG
+#endif
+#else
+        void disconnect() {}
+#endif // TINYFORMAT_SINKS_POSIX
+
+    private:
+        // Noncopyable
+        SyslogWriter(const SyslogWriter&);
+        SyslogWriter& operator=(const SyslogWriter&);
+
+        // Append a header field followed by a space.  Fields are limited to
+        // printable ASCII without spaces.
+        void appendField(const std::string& field)
+        {
+            if(field.empty())
+                m_header += '-';
+            for(size_t i = 0; i < field.size(); ++i)
+            {
+                char c = field[i];
+                m_header += (c > ' ' && c < 127) ? c : '_';
+            }
+            m_header += ' ';
+        }
+
+        int m_facility;
+        std::string m_header;
+        detail::SmallStreamBuf<1024> m_buf;
+        std::ostream m_stream;
+        long long m_cachedSecond;
+        char m_cachedDateTime[19];
+        int m_socket;
+};
+
+
+
+//------------------------------------------------------------------------------
+/// A metric name with a fixed set of labels, for use with MetricsWriter.
+///
+/// The text "name{label="value",...} " which starts each sample line is
+/// rendered and escaped once when the series is set up, so writing a sample
+/// only needs to append this prefix and the value.  Label values may have any
+/// type which tinyformat can format.
+///
+///   tfm::MetricSeries getOk("http_requests_total");
+///   getOk.label("method", "GET").label("code", 200);
+class MetricSeries
+{
+    public:
+        explicit MetricSeries(const std::string& name)
+            : m_name(name), m_prefix(name + ' ')
+        { }
+
+        /// Add a label to the series
+        template<typename T>
+        MetricSeries& label(const std::string& name, const T& value)
+        {
+            std::string text = tfm::format("%s", value);
+            if(!m_labels.empty())
+                m_labels += ',';
+            m_labels += name;
+            m_labels += "=\"";
+            for(size_t i = 0; i < text.size(); ++i)
+            {
+                switch(text[i])
+                {
+                    case '\\': m_labels += "\\\\"; break;
+                    case '"':  m_labels += "\\\""; break;
+                    case '\n': m_labels += "\\n";  break;
+                    default:   m_labels += text[i]; break;
+                }
+            }
+            m_labels += '"';
+            m_prefix = m_name + '{' + m_labels + "} ";
+            return *this;
+        }
+
+        /// Text preceding the value on each sample line
+        const std::string& prefix() const { return m_prefix; }
+
+    private:
+        std::string m_name;
+        std::string m_labels;
+        std::string m_prefix;
+};
+
+
+/// Writer for the Prometheus text exposition format.
+///
+/// All output is appended to a single growable buffer which is reused between
+/// scrapes, so rendering a large number of series involves no per-line stream
+/// or string allocations.  Sample values are written in the shortest form
+/// which round trips to the same double, independent of the locale.
+///
+///   tfm::MetricsWriter metrics;
+///   metrics.type("http_requests_total", "counter");
+///   metrics.sample(getOk, 1027);
+///   send(fd, metrics.data(), metrics.size());
+class MetricsWriter
+{
+    public:
+        /// Write a "# HELP" line.  Backslashes and newlines in the text are
+        /// escaped.
+        void help(const std::string& name, const std::string& text)
+        {
+            m_out += "# HELP ";
+            m_out += name;
+            m_out += ' ';
+            for(size_t i = 0; i < text.size(); ++i)
+            {
+                if(text[i] == '\\')
+                    m_out += "\\\\";
+                else if(text[i] == '\n')
+                    m_out += "\\n";
+                else
+                    m_out += text[i];
+            }
+            m_out += '\n';
+        }
+
+        /// Write a "# TYPE" line, where type is counter, gauge, histogram,
+        /// summary or untyped.
+        void type(const std::string& name, const char* type)
+        {
+            m_out += "# TYPE ";
+            m_out += name;
+            m_out += ' ';
+            m_out += type;
+            m_out += '\n';
+        }
+
+        /// Write a sample line for the series.
+        void sample(const MetricSeries& series, double value)
+        {
+            char buf[32];
+            m_out += series.prefix();
+            m_out.append(buf, m_doubleWriter.write(buf, value) - buf);
+            m_out += '\n';
+        }
+
+        /// Write a sample line with a timestamp in milliseconds since the
+        /// epoch.
+        void sample(const MetricSeries& series, double value, long long timestampMs)
+        {
+            char buf[56];
+            char* p = m_doubleWriter.write(buf, value);
+            *p++ = ' ';
+            if(timestampMs < 0)
+            {
+                *p++ = '-';
+                timestampMs = -timestampMs;
+            }
+            p = detail::writeDecimal(p, static_cast<unsigned long long>(timestampMs));
+            *p++ = '\n';
+            m_out += series.prefix();
+            m_out.append(buf, p - buf);
+        }
+
+        const char* data() const { return m_out.data(); }
+        size_t size() const { return m_out.size(); }
+        const std::string& str() const { return m_out; }
+
+        /// Empty the buffer, keeping its storage for the next scrape.
+        void clear() { m_out.clear(); }
+
+    private:
+        std::string m_out;
+        detail::ShortestDoubleWriter m_doubleWriter;
+};
+
+
+
+//------------------------------------------------------------------------------
+/// Writer for CSV and TSV records.
+///
+/// Each field is formatted by tinyformat directly into the writer's buffer,
+/// either with "%s" or with a given format spec.  A fast scan then checks the
+/// field for characters which need special treatment; only if there are any
+/// is the field rewritten with RFC 4180 quoting (for CSV), or with \t, \n,
+/// \r and \\ escapes (for TSV, where quoting is not used).  Rows collect in
+/// the buffer, which is written to the output stream in large blocks.
+///
+///   tfm::CsvWriter csv(file);
+///   csv.row("id", "name", "score");
+///   csv.field(id).field(name).field("%.3f", score).endRow();
+///
+/// rows() writes a whole batch of rows held in containers, checking whether
+/// to flush only once at the end.
+class CsvWriter
+{
+    public:
+        /// Write rows to out, separating fields with separator (use '\t'
+        /// for TSV).  Output is passed on to out whenever at least
+        /// flushSize bytes have been buffered, and on destruction.  Each
+        /// row ends with lineEnd, by default "\r\n" for CSV as in RFC 4180
+        /// and "\n" for TSV.
+        explicit CsvWriter(std::ostream& out, char separator = ',',
+                           size_t flushSize = 65536, const char* lineEnd = 0)
+            : m_out(out),
+            m_stream(&m_buf),
+            m_separator(separator),
+            m_lineEnd(lineEnd ? lineEnd : separator == '\t' ? "\n" : "\r\n"),
+            m_lineEndLen(static_cast<std::streamsize>(std::strlen(m_lineEnd))),
+            m_flushSize(static_cast<std::streamsize>(flushSize)),
+            m_rowStart(true)
+        {
+            if(separator == '\t')
+            {
+                m_special[0] = '\t'; m_special[1] = '\n';
+                m_special[2] = '\r'; m_special[3] = '\\';
+            }
+            else
+            {
+                m_special[0] = separator; m_special[1] = '"';
+                m_special[2] = '\n'; m_special[3] = '\r';
+            }
+        }
+
+        ~CsvWriter()
+        {
+            flush();
+        }
+
+        /// Append a field formatted with "%s"
+        template<typename T>
+        CsvWriter& field(const T& value)
+        {
+            std::streamsize start = beginField();
+            format(m_stream, "%s", value);
+            endField(start);
+            return *this;
+        }
+
+        /// Append a field formatted according to the given format string,
+        /// for example "%.2f"
+        template<typename T>
+        CsvWriter& field(const char* fmt, const T& value)
+        {
+            std::streamsize start = beginField();
+            format(m_stream, fmt, value);
+            endField(start);
+            return *this;
+        }
+
+        /// Terminate the current row
+        void endRow()
+        {
+            terminateRow();
+            if(m_buf.size() >= m_flushSize)
+                flush();
+        }
+
+        /// Write a row for each element from first to last, which must
+        /// itself be a range of fields, such as a std::vector<std::string>
+        template<typename Iterator>
+        void rows(Iterator first, Iterator last)
+        {
+            typedef typename std::iterator_traits<Iterator>::value_type Row;
+            for(; first != last; ++first)
+            {
+                const Row& r = *first;
+                for(typename Row::const_iterator f = r.begin(); f != r.end(); ++f)
+                    field(*f);
+                terminateRow();
+            }
+            if(m_buf.size() >= m_flushSize)
+                flush();
+        }
+
+        /// Write a row for each element of a range of rows
+        template<typename Range>
+        void rows(const Range& range)
+        {
+            rows(range.begin(), range.end());
+        }
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        /// Write a complete row with each argument formatted as a field
+        template<typename... Args>
+        void row(const Args&... args)
+        {
+            int dummy[] = {0, (field(args), 0)...};
+            (void)dummy;
+            endRow();
+        }
+#else
+#       define TINYFORMAT_MAKE_CSV_ROW(n)                                      \
+        template<TINYFORMAT_ARGTYPES(n)>                                       \
+        void row(TINYFORMAT_VARARGS(n))                                        \
+        {                                                                      \
+            rowFields(0, TINYFORMAT_PASSARGS(n));                              \
+            endRow();                                                          \
+        }
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_CSV_ROW)
+#       undef TINYFORMAT_MAKE_CSV_ROW
+#endif
+
+        /// Pass all buffered rows on to the output stream
+        void flush()
+        {
+            m_out.write(m_buf.data(), m_buf.size());
+            m_buf.clear();
+        }
+
+    private:
+        // Noncopyable
+        CsvWriter(const CsvWriter&);
+        CsvWriter& operator=(const CsvWriter&);
+
+#ifndef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        // Append the arguments of row() as fields, one per recursion
+#       define TINYFORMAT_MAKE_CSV_ROW_FIELDS(n)                               \
+        template<TINYFORMAT_ARGTYPES(n)>                                       \
+        void rowFields(int, TINYFORMAT_VARARGS(n))                             \
+        {                                                                      \
+            field(v1);                                                         \
+            rowFields(0 TINYFORMAT_PASSARGS_TAIL(n));                          \
+        }
+        void rowFields(int) {}
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_CSV_ROW_FIELDS)
+#       undef TINYFORMAT_MAKE_CSV_ROW_FIELDS
+#endif
+
+        void terminateRow()
+        {
+            m_buf.sputn(m_lineEnd, m_lineEndLen);
+            m_rowStart = true;
+        }
+
+        std::streamsize beginField()
+        {
+            if(!m_rowStart)
+                m_buf.sputc(m_separator);
+            m_rowStart = false;
+            return m_buf.size();
+        }
+
+        // Quote or escape the field starting at start, if necessary.  The
+        // buffer is extended by the number of characters added, and the
+        // field rewritten in place from the back.
+        void endField(std::streamsize start)
+        {
+            const char* text = m_buf.data() + start;
+            std::streamsize len = m_buf.size() - start;
+            if(!detail::containsAnyOf4(text, len, m_special))
+                return;
+            bool quote = m_separator != '\t';
+            std::streamsize extra = quote ? 2 : 0;
+            for(std::streamsize i = 0; i < len; ++i)
+            {
+                if(quote ? text[i] == '"'
+                         : std::memchr(m_special, text[i], sizeof(m_special)) != 0)
+                    ++extra;
+            }
+            for(std::streamsize i = 0; i < extra; ++i)
+                m_buf.sputc(' ');
+            char* begin = m_buf.data() + start;
+            const char* src = begin + len;
+            char* dst = begin + len + extra;
+            if(quote)
+                *--dst = '"';
+            while(src != begin)
+            {
+                char c = *--src;
+                if(quote)
+                {
+                    *--dst = c;
+                    if(c == '"')
+                        *--dst = '"';
+                    continue;
+                }
+                switch(c)
+                {
+                    case '\t': *--dst = 't';  break;
+                    case '\n': *--dst = 'n';  break;
+                    case '\r': *--dst = 'r';  break;
+                    case '\\': *--dst = '\\'; break;
+                    default:   *--dst = c;    continue;
+                }
+                *--dst = '\\';
+            }
+            if(quote)
+                *--dst = '"';
+        }
+
+        std::ostream& m_out;
+        detail::SmallStreamBuf<4096> m_buf;
+        std::ostream m_stream;
+        char m_separator;
+        const char* m_lineEnd;
+        std::streamsize m_lineEndLen;
+        char m_special[4];
+        std::streamsize m_flushSize;
+        bool m_rowStart;
+};
+
+
+
+//------------------------------------------------------------------------------
+/// Writer which formats each message once and sends it to several streams.
+///
+/// Each destination has a maximum level: a message is sent to the
+/// destinations whose maximum level is at least the level of the message, so
+/// with the usual convention of small numbers for severe messages a file
+/// might receive everything while stderr only receives errors.  The message
+/// is formatted into an internal buffer and the bytes written to each
+/// destination in turn, so the formatting cost doesn't depend on the number
+/// of destinations.  Messages which no destination accepts aren't formatted
+/// at all.
+///
+///   tfm::TeeWriter log;
+///   log.addStream(logFile, LOG_DEBUG);
+///   log.addStream(std::cerr, LOG_ERR);
+///   log.log(LOG_WARNING, "retrying %s in %d ms", host, delay);
+class TeeWriter
+{
+    public:
+        TeeWriter() : m_stream(&m_buf), m_maxLevel(-1) {}
+
+        /// Add a destination stream for messages up to the given level.  The
+        /// stream must outlive the writer.
+        void addStream(std::ostream& out, int maxLevel)
+        {
+            Destination d = { &out, maxLevel };
+            m_destinations.push_back(d);
+            m_maxLevel = (std::max)(m_maxLevel, maxLevel);
+        }
+
+        /// Return true if any destination accepts messages at this level.
+        /// Can be used to skip work needed to compute the arguments.
+        bool enabled(int level) const { return level <= m_maxLevel; }
+
+        /// Format a message, append a newline and write it to every
+        /// destination which accepts the level.
+        void vlog(int level, const char* fmt, FormatListRef list)
+        {
+            if(!enabled(level))
+                return;
+            m_buf.clear();
+            vformat(m_stream, fmt, list);
+            m_buf.sputc('\n');
+            for(size_t i = 0; i < m_destinations.size(); ++i)
+            {
+                if(level <= m_destinations[i].maxLevel)
+                    m_destinations[i].out->write(m_buf.data(), m_buf.size());
+            }
+        }
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        template<typename... Args>
+        void log(int level, const char* fmt, const Args&... args)
+        {
+            if(enabled(level))
+                vlog(level, fmt, makeFormatList(args...));
+        }
+#else
+        void log(int level, const char* fmt)
+        {
+            if(enabled(level))
+                vlog(level, fmt, makeFormatList());
+        }
+#       define TINYFORMAT_MAKE_TEE_LOG(n)                                      \
+        template<TINYFORMAT_ARGTYPES(n)>                                       \
+        void log(int level, const char* fmt, TINYFORMAT_VARARGS(n))            \
+        {                                                                      \
+            if(enabled(level))                                                 \
+                vlog(level, fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));      \
+        }
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_TEE_LOG)
+#       undef TINYFORMAT_MAKE_TEE_LOG
+#endif
+
+    private:
+        // Noncopyable
+        TeeWriter(const TeeWriter&);
+        TeeWriter& operator=(const TeeWriter&);
+
+        struct Destination
+        {
+            std::ostream* out;
+            int maxLevel;
+        };
+
+        detail::SmallStreamBuf<512> m_buf;
+        std::ostream m_stream;
+        std::vector<Destination> m_destinations;
+        int m_maxLevel;
+};
+
+//------------------------------------------------------------------------------
+/// Writer which suppresses repeated messages.
+///
+/// Messages are identified by the address of the format string and the raw
+/// values of the arguments, so a repeat of a recent message is detected
+/// without formatting it.  Messages with arguments of other types, such as
+/// pointers to anything but void or user defined types, are identified by
+/// their formatted text instead.  Repeats within the time window of the
+/// first occurrence are counted rather than written, and a single summary
+/// line is written for them once the window has passed and the message
+/// occurs again, when the message is displaced by others, or on flush():
+///
+///   tfm::DuplicateFilter log(std::cerr, 10);
+///   for(;;)
+///       log.log("read from %s failed: %s", path, strerror(errno));
+///   // read from /dev/foo failed: Input/output error
+///   // message repeated 5432 times: read from /dev/foo failed: ...
+///
+/// Several distinct messages are tracked at once, so interleaved repeats are
+/// suppressed too.
+class DuplicateFilter
+{
+    public:
+        /// Write messages to out, suppressing repeats for windowSeconds
+        DuplicateFilter(std::ostream& out, double windowSeconds)
+            : m_out(out), m_window(windowSeconds), m_useCount(0)
+        {
+            for(int i = 0; i < numSlots; ++i)
+            {
+                m_slots[i].used = false;
+                m_slots[i].lastUse = 0;
+            }
+        }
+
+        ~DuplicateFilter() { flush(); }
+
+        /// Write a message, followed by a newline, unless it's a repeat.
+        /// Returns false if the message was suppressed.
+        bool vlog(const char* fmt, FormatListRef list)
+        {
+            // Messages are identified by the format string address and the
+            // argument values, or by their formatted text if any argument
+            // has another type.  The key is compared in full when the hash
+            // matches, so a hash collision can't hide a different message.
+            // It's built in a member buffer which keeps its capacity, so
+            // once warmed up, suppressing a repeat doesn't allocate.
+            m_key.assign(1, 'v');
+            bool formatted = false;
+            if(!detail::appendMessageKey(m_key, fmt, list))
+            {
+                formatMessage(fmt, list);
+                formatted = true;
+                m_key.assign(1, 't');
+                m_key.append(m_buf.data(), static_cast<size_t>(m_buf.size()));
+            }
+            unsigned long long hash = detail::fnv1a(detail::fnvOffsetBasis,
+                                                    m_key.data(), m_key.size());
+            double now = currentTime();
+            Slot* slot = 0;
+            Slot* oldest = &m_slots[0];
+            for(int i = 0; i < numSlots && !slot; ++i)
+            {
+                if(m_slots[i].used && m_slots[i].hash == hash && m_slots[i].key == m_key)
+                    slot = &m_slots[i];
+                else if(m_slots[i].lastUse < oldest->lastUse)
+                    oldest = &m_slots[i];
+            }
+            if(slot && now - slot->start < m_window)
+            {
+                ++slot->repeats;
+                slot->lastUse = ++m_useCount;
+                return false;
+            }
+            if(!slot)
+                slot = oldest;
+            writeSummary(*slot);
+            slot->used = true;
+            slot->hash = hash;
+            slot->key.assign(m_key);
+            slot->start = now;
+            slot->repeats = 0;
+            slot->lastUse = ++m_useCount;
+            if(!formatted)
+                formatMessage(fmt, list);
+            slot->text.assign(m_buf.data(), static_cast<size_t>(m_buf.size()));
+            m_out << slot->text << '\n';
+            return true;
+        }
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        template<typename... Args>
+        bool log(const char* fmt, const Args&... args)
+        {
+            return vlog(fmt, makeFormatList(args...));
+        }
+#else
+        bool log(const char* fmt)
+        {
+            return vlog(fmt, makeFormatList());
+        }
+#       define TINYFORMAT_MAKE_DUPLICATE_LOG(n)                                \
+        template<TINYFORMAT_ARGTYPES(n)>                                       \
+        bool log(const char* fmt, TINYFORMAT_VARARGS(n))                       \
+        {                                                                      \
+            return vlog(fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));          \
+        }
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_DUPLICATE_LOG)
+#       undef TINYFORMAT_MAKE_DUPLICATE_LOG
+#endif
+
+        /// Write summaries for all suppressed repeats, and forget the
+        /// messages seen so far.
+        void flush()
+        {
+            for(int i = 0; i < numSlots; ++i)
+            {
+                writeSummary(m_slots[i]);
+                m_slots[i].used = false;
+            }
+        }
+
+    private:
+        // Noncopyable
+        DuplicateFilter(const DuplicateFilter&);
+        DuplicateFilter& operator=(const DuplicateFilter&);
+
+        static const int numSlots = 8;
+
+        struct Slot
+        {
+            bool used;
+            unsigned long long hash;
+            std::string key;
+            double start;
+            unsigned long repeats;
+            unsigned long lastUse;
+            std::string text;
+        };
+
+        void formatMessage(const char* fmt, FormatListRef list)
+        {
+            m_buf.clear();
+            std::ostream tmp(&m_buf);
+            vformat(tmp, fmt, list);
+        }
+
+        void writeSummary(Slot& slot)
+        {
+            if(slot.used && slot.repeats > 0)
+                format(m_out, "message repeated %lu times: %s\n", slot.repeats, slot.text);
+            slot.repeats = 0;
+        }
+
+        static double currentTime()
+        {
+#ifdef TINYFORMAT_SINKS_POSIX
+            timeval tv;
+            gettimeofday(&tv, 0);
+            return tv.tv_sec + 1e-6*tv.tv_usec;
+#else
+            return static_cast<double>(std::time(0));
+#endif
+        }
+
+        std::ostream& m_out;
+        double m_window;
+        unsigned long m_useCount;
+        Slot m_slots[numSlots];
+        std::string m_key;
+        detail::SmallStreamBuf<256> m_buf;
+};
+
+#endif // TINYFORMAT_NO_HEAP
+
+
+//------------------------------------------------------------------------------
+namespace detail {
+
+// Stream buffer which passes output to consume() in chunks, collected in a
+// small fixed buffer so that single characters don't each cost a virtual
+// call.
+class ChunkStreamBuf : public std::streambuf
+{
+    public:
+        ChunkStreamBuf() { setp(m_chunk, m_chunk + sizeof(m_chunk)); }
+
+    protected:
+        virtual void consume(const char* s, std::streamsize n) = 0;
+
+        // Consume the buffered output
+        void flushChunk()
+        {
+            if(pptr() != pbase())
+                consume(pbase(), pptr() - pbase());
+            setp(m_chunk, m_chunk + sizeof(m_chunk));
+        }
+
+        virtual int_type overflow(int_type c)
+        {
+            flushChunk();
+            if(!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        virtual std::streamsize xsputn(const char* s, std::streamsize n)
+        {
+            if(epptr() - pptr() < n)
+            {
+                flushChunk();
+                if(n >= static_cast<std::streamsize>(sizeof(m_chunk)))
+                {
+                    consume(s, n);
+                    return n;
+                }
+            }
+            std::memcpy(pptr(), s, static_cast<size_t>(n));
+            pbump(static_cast<int>(n));
+            return n;
+        }
+
+        virtual int sync()
+        {
+            flushChunk();
+            return 0;
+        }
+
+    private:
+        char m_chunk[128];
+};
+
+} // namespace detail
+
+
+/// Stream buffer which computes the 64 bit FNV-1a hash of the output, without
+/// storing it.  Useful for building cache keys from formatted values:
+///
+///   tfm::HashStreamBuf buf;
+///   std::ostream out(&buf);
+///   tfm::format(out, "%s:%d", host, port);
+///   unsigned long long key = buf.hash();
+class HashStreamBuf : public detail::ChunkStreamBuf
+{
+    public:
+        HashStreamBuf() : m_hash(detail::fnvOffsetBasis) { }
+
+        /// Hash of all output so far
+        unsigned long long hash()
+        {
+            flushChunk();
+            return m_hash;
+        }
+
+    protected:
+        virtual void consume(const char* s, std::streamsize n)
+        {
+            m_hash = detail::fnv1a(m_hash, s, static_cast<size_t>(n));
+        }
+
+    private:
+        unsigned long long m_hash;
+};
+
+
+/// Stream buffer which counts the characters of output without storing them
+class CountingStreamBuf : public detail::ChunkStreamBuf
+{
+    public:
+        CountingStreamBuf() : m_count(0) { }
+
+        /// Number of characters output so far
+        std::streamsize count() const { return m_count + (pptr() - pbase()); }
+
+    protected:
+        virtual void consume(const char* /*s*/, std::streamsize n)
+        {
+            m_count += n;
+        }
+
+    private:
+        std::streamsize m_count;
+};
+
+
+/// Stream buffer which compares the output with an expected string, without
+/// storing it.  At the first mismatch the stream buffer reports a write
+/// failure, so that the stream goes bad and further output is skipped.
+class CompareStreamBuf : public std::streambuf
+{
+    public:
+        CompareStreamBuf(const char* expected, std::streamsize len)
+            : m_expected(expected), m_len(len), m_pos(0), m_mismatch(false) { }
+
+        /// Return true if the output so far is the whole expected string
+        bool matches() const { return !m_mismatch && m_pos == m_len; }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if(traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
+            char ch = traits_type::to_char_type(c);
+            return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+        }
+
+        virtual std::streamsize xsputn(const char* s, std::streamsize n)
+        {
+            if(m_mismatch || n > m_len - m_pos ||
+               std::memcmp(m_expected + m_pos, s, static_cast<size_t>(n)) != 0)
+            {
+                m_mismatch = true;
+                return 0;
+            }
+            m_pos += n;
+            return n;
+        }
+
+    private:
+        const char* m_expected;
+        std::streamsize m_len;
+        std::streamsize m_pos;
+        bool m_mismatch;
+};
+
+
+/// FNV-1a hash of the formatted output, computed without storing it
+inline unsigned long long vformatHash(const char* fmt, FormatListRef list)
+{
+    HashStreamBuf buf;
+    std::ostream out(&buf);
+    detail::formatList(out, fmt, list);
+    return buf.hash();
+}
+
+/// Length of the formatted output, computed without storing it
+inline size_t vformattedLength(const char* fmt, FormatListRef list)
+{
+    CountingStreamBuf buf;
+    std::ostream out(&buf);
+    detail::formatList(out, fmt, list);
+    return static_cast<size_t>(buf.count());
+}
+
+/// Return true if the formatted output equals expected.  Formatting stops at
+/// the first mismatch.
+inline bool vformatEquals(const char* expected, size_t expectedLen,
+                          const char* fmt, FormatListRef list)
+{
+    CompareStreamBuf buf(expected, static_cast<std::streamsize>(expectedLen));
+    std::ostream out(&buf);
+    detail::formatList(out, fmt, list);
+    return buf.matches();
+}
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+
+template<typename... Args>
+unsigned long long formatHash(const char* fmt, const Args&... args)
+{
+    return vformatHash(fmt, makeFormatList(args...));
+}
+
+template<typename... Args>
+size_t formattedLength(const char* fmt, const Args&... args)
+{
+    return vformattedLength(fmt, makeFormatList(args...));
+}
+
+template<typename... Args>
+bool formatEquals(const std::string& expected, const char* fmt, const Args&... args)
+{
+    return vformatEquals(expected.data(), expected.size(), fmt,
+                         makeFormatList(args...));
+}
+
+template<typename... Args>
+bool formatEquals(const char* expected, const char* fmt, const Args&... args)
+{
+    return vformatEquals(expected, std::strlen(expected), fmt,
+                         makeFormatList(args...));
+}
+
+#else // C++98 version
+
+inline unsigned long long formatHash(const char* fmt)
+{
+    return vformatHash(fmt, makeFormatList());
+}
+
+inline size_t formattedLength(const char* fmt)
+{
+    return vformattedLength(fmt, makeFormatList());
+}
+
+inline bool formatEquals(const std::string& expected, const char* fmt)
+{
+    return vformatEquals(expected.data(), expected.size(), fmt, makeFormatList());
+}
+
+inline bool formatEquals(const char* expected, const char* fmt)
+{
+    return vformatEquals(expected, std::strlen(expected), fmt, makeFormatList());
+}
+
+#define TINYFORMAT_MAKE_OUTPUT_CHECK_FUNCS(n)                                 \
+                                                                              \
+template<TINYFORMAT_ARGTYPES(n)>                                              \
+unsigned long long formatHash(const char* fmt, TINYFORMAT_VARARGS(n))         \
+{                                                                             \
+    return vformatHash(fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));          \
+}                                                                             \
+                                                                              \
+template<TINYFORMAT_ARGTYPES(n)>                                              \
+size_t formattedLength(const char* fmt, TINYFORMAT_VARARGS(n))                \
+{                                                                             \
+    return vformattedLength(fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));     \
+}                                                                             \
+                                                                              \
+template<TINYFORMAT_ARGTYPES(n)>                                              \
+bool formatEquals(const std::string& expected, const char* fmt,              \
+                  TINYFORMAT_VARARGS(n))                                      \
+{                                                                             \
+    return vformatEquals(expected.data(), expected.size(), fmt,               \
+                         makeFormatList(TINYFORMAT_PASSARGS(n)));             \
+}                                                                             \
+                                                                              \
+template<TINYFORMAT_ARGTYPES(n)>                                              \
+bool formatEquals(const char* expected, const char* fmt,                     \
+                  TINYFORMAT_VARARGS(n))                                      \
+{                                                                             \
+    return vformatEquals(expected, std::strlen(expected), fmt,                \
+                         makeFormatList(TINYFORMAT_PASSARGS(n)));             \
+}
+
+TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_OUTPUT_CHECK_FUNCS)
+#undef TINYFORMAT_MAKE_OUTPUT_CHECK_FUNCS
+
+#endif
+
+
+//------------------------------------------------------------------------------
+/// Writer for length-prefixed frames of formatted text.
+///
+/// For each frame a fixed size slot for the length header is reserved in the
+/// writer's buffer, the payload is formatted directly after it, and the
+/// header is filled in once the payload length is known.  This avoids
+/// formatting into a temporary string just to measure it.  Frames accumulate
+/// in the buffer until it is cleared, so several can be sent together.
+/// With TINYFORMAT_NO_HEAP the buffer holds at most 1024 bytes, and payloads
+/// which would overflow it are truncated.
+///
+///   tfm::FrameWriter frames(tfm::FrameWriter::BigEndian32);
+///   frames.frame("PUT %s %d", key, value);
+///   send(fd, frames.data(), frames.size(), 0);
+///   frames.clear();
+class FrameWriter
+{
+    public:
+        /// Length header encodings
+        enum HeaderType
+        {
+            BigEndian16,     ///< two byte unsigned, network byte order
+            BigEndian32,     ///< four byte unsigned, network byte order
+            LittleEndian32,  ///< four byte unsigned, little endian
+            /// Unsigned LEB128 varint, as used by protocol buffers.  Since the
+            /// slot size must be fixed in advance, it is always five bytes,
+            /// with unused high groups encoded as 0x80 continuation bytes;
+            /// standard varint decoders accept this padded form.
+            Varint32
+        };
+
+        explicit FrameWriter(HeaderType headerType)
+            : m_headerType(headerType), m_stream(&m_buf)
+        { }
+
+        /// Append a frame with the formatted payload.  Returns false if the
+        /// frame was dropped, leaving the buffer unchanged: with
+        /// TINYFORMAT_NO_HEAP, when the frame doesn't fit in the fixed
+        /// buffer, and when the payload is too long for the header, which is
+        /// also reported with TINYFORMAT_ERROR.
+        bool vframe(const char* fmt, FormatListRef list)
+        {
+            static const char zeros[5] = {0, 0, 0, 0, 0};
+            // Remove the partial frame unless completed, including when
+            // formatting throws
+            Rollback rollback(*this, m_buf.size());
+            int headerLen = headerSize();
+            if(m_buf.sputn(zeros, headerLen) != headerLen)
+                return false;
+            detail::formatList(m_stream, fmt, list);
+            if(!m_stream)
+            {
+                // Output was discarded by a fixed size buffer
+                m_stream.clear();
+                return false;
+            }
+            unsigned long long len = m_buf.size() - rollback.start - headerLen;
+            if(len > maxPayload())
+            {
+                rollback.undo();
+                TINYFORMAT_ERROR("tinyformat: Frame payload too large for length header");
+                return false;
+            }
+            unsigned char* h = reinterpret_cast<unsigned char*>(m_buf.data() + rollback.start);
+            switch(m_headerType)
+            {
+                case BigEndian16:
+                    h[0] = static_cast<unsigned char>(len >> 8);
+                    h[1] = static_cast<unsigned char>(len);
+                    break;
+                case BigEndian32:
+                    for(int i = 0; i < 4; ++i)
+                        h[i] = static_cast<unsigned char>(len >> 8*(3 - i));
+                    break;
+                case LittleEndian32:
+                    for(int i = 0; i < 4; ++i)
+                        h[i] = static_cast<unsigned char>(len >> 8*i);
+                    break;
+                case Varint32:
+                    for(int i = 0; i < 5; ++i)
+                        h[i] = static_cast<unsigned char>(((len >> 7*i) & 0x7f) | (i < 4 ? 0x80 : 0));
+                    break;
+            }
+            rollback.start = -1;
+            return true;
+        }
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+        template<typename... Args>
+        bool frame(const char* fmt, const Args&... args)
+        {
+            return vframe(fmt, makeFormatList(args...));
+        }
+#else
+        bool frame(const char* fmt)
+        {
+            return vframe(fmt, makeFormatList());
+        }
+#       define TINYFORMAT_MAKE_FRAME(n)                                        \
+        template<TINYFORMAT_ARGTYPES(n)>                                       \
+        bool frame(const char* fmt, TINYFORMAT_VARARGS(n))                     \
+        {                                                                      \
+            return vframe(fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));        \
+        }
+        TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_FRAME)
+#       undef TINYFORMAT_MAKE_FRAME
+#endif
+
+        const char* data() const { return m_buf.data(); }
+        size_t size() const { return static_cast<size_t>(m_buf.size()); }
+
+        /// Discard all frames, keeping the buffer storage for reuse.
+        void clear() { m_buf.clear(); }
+
+    private:
+        // Noncopyable
+        FrameWriter(const FrameWriter&);
+        FrameWriter& operator=(const FrameWriter&);
+
+        // Truncates the buffer back to start on destruction, unless start is
+        // reset to -1 when the frame is complete.
+        struct Rollback
+        {
+            FrameWriter& writer;
+            std::streamsize start;
+
+            Rollback(FrameWriter& w, std::streamsize s) : writer(w), start(s) { }
+            ~Rollback() { undo(); }
+
+            void undo()
+            {
+                if(start < 0)
+                    return;
+                writer.m_buf.truncate(start);
+                writer.m_stream.clear();
+                start = -1;
+            }
+        };
+
+        int headerSize() const
+        {
+            switch(m_headerType)
+            {
+                case BigEndian16: return 2;
+                case Varint32:    return 5;
+                default:          return 4;
+            }
+        }
+
+        unsigned long long maxPayload() const
+        {
+            return m_headerType == BigEndian16 ? 0xffffUL : 0xffffffffUL;
+        }
+
+        HeaderType m_headerType;
+        detail::SmallStreamBuf<1024> m_buf;
+        std::ostream m_stream;
+};
+
+
+#ifdef TINYFORMAT_SINKS_POSIX
+
+//------------------------------------------------------------------------------
+/// Restricted formatting for use in signal handlers.
+///
+/// tfm::format() and friends use iostreams and may allocate memory, so they
+/// must not be used in a signal handler.  signal_safe::dprintf() supports the
+/// integer, character, string and pointer conversions with only fixed size
+/// stack buffers and write(2), all of which are async-signal-safe:
+///
+///   void onSegv(int sig, siginfo_t* info, void*)
+///   {
+///       tfm::signal_safe::dprintf(2, "signal %d at address %p\n",
+///                                 sig, info->si_addr);
+///   }
+///
+/// Arguments must be integers, characters, C strings or pointers; passing
+/// any other type fails to compile.  Supported conversions are %d %i %u %o
+/// %x %X %c %s %p with flags, width and precision; length modifiers are
+/// accepted and ignored.  Since the format string is only known at runtime,
+/// an unsupported conversion, or %c with a string argument, is written as a
+/// marker like "%!f" in place of its argument, and a conversion without an
+/// argument as "%!d(missing)".
+///
+/// In C++11, TINYFORMAT_SIGNAL_SAFE_DPRINTF() checks a literal format string
+/// at compile time instead, rejecting unsupported conversions, mismatched
+/// argument types and a wrong number of arguments:
+///
+///   TINYFORMAT_SIGNAL_SAFE_DPRINTF(2, "signal %d at address %p\n",
+///                                  sig, info->si_addr);
+namespace signal_safe {
+
+namespace detail {
+
+// Argument to dprintf(), converted from one of the supported types.
+class Arg
+{
+    public:
+        enum Kind { Signed, Unsigned, Char, String, Pointer };
+
+#       define TINYFORMAT_SIGNAL_SAFE_INT(type, utype)                      \
+        Arg(type v)                                                         \
+            : m_kind(Signed), m_int(v),                                     \
+            m_uint(static_cast<unsigned long long>(static_cast<utype>(v))), \
+            m_str(0)                                                        \
+        { }                                                                 \
+        Arg(utype v) : m_kind(Unsigned), m_int(0), m_uint(v), m_str(0) { }
+        TINYFORMAT_SIGNAL_SAFE_INT(short, unsigned short)
+        TINYFORMAT_SIGNAL_SAFE_INT(int, unsigned int)
+        TINYFORMAT_SIGNAL_SAFE_INT(long, unsigned long)
+        TINYFORMAT_SIGNAL_SAFE_INT(long long, unsigned long long)
+#       undef TINYFORMAT_SIGNAL_SAFE_INT
+        Arg(bool v) : m_kind(Unsigned), m_int(0), m_uint(v), m_str(0) { }
+        Arg(char v) { initChar(v, static_cast<unsigned char>(v)); }
+        Arg(signed char v) { initChar(v, static_cast<unsigned char>(v)); }
+        Arg(unsigned char v) { initChar(v, v); }
+        Arg(const char* s) { initPointer(String, s, s); }
+        Arg(char* s) { initPointer(String, s, s); }
+        template<typename T>
+        Arg(T* p) { initPointer(Pointer, static_cast<const volatile void*>(p), 0); }
+
+        Kind kind() const { return m_kind; }
+        long long intValue() const { return m_int; }
+        unsigned long long uintValue() const { return m_uint; }
+        const char* str() const { return m_str; }
+
+    private:
+        void initChar(int v, unsigned char u)
+        {
+            m_kind = Char;
+            m_int = v;
+            m_uint = u;
+            m_str = 0;
+        }
+
+        void initPointer(Kind kind, const volatile void* p, const char* s)
+        {
+            m_kind = kind;
+            m_int = 0;
+            m_uint = reinterpret_cast<std::size_t>(p);
+            m_str = s;
+        }
+
+        // Only the types above are supported.  Other argument types select
+        // this inaccessible constructor, giving an error at compile time.
+        template<typename T>
+        Arg(const T&);
+
+        Kind m_kind;
+        long long m_int;
+        unsigned long long m_uint;
+        const char* m_str;
+};
+
+// Buffered writer to a file descriptor, using only write(2)
+class FdWriter
+{
+    public:
+        explicit FdWriter(int fd) : m_fd(fd), m_len(0), m_total(0), m_failed(false) { }
+
+        void write(const char* s, int n)
+        {
+            for(int i = 0; i < n; ++i)
+                put(s[i]);
+        }
+
+        void put(char c)
+        {
+            if(m_len == static_cast<int>(sizeof(m_buf)))
+                flush();
+            m_buf[m_len++] = c;
+            ++m_total;
+        }
+
+        void fill(char c, int n)
+        {
+            for(int i = 0; i < n; ++i)
+                put(c);
+        }
+
+        // Write out buffered characters, retrying after interruptions and
+        // partial writes.  Returns false if any write has failed.  errno is
+        // left unchanged, as signal handlers must.
+        bool flush()
+        {
+            int savedErrno = errno;
+            const char* p = m_buf;
+            while(m_len > 0 && !m_failed)
+            {
+                ssize_t n = ::write(m_fd, p, m_len);
+                if(n > 0)
+                {
+                    p += n;
+                    m_len -= static_cast<int>(n);
+                }
+                else if(n < 0 && errno == EINTR)
+                    continue;
+                else
+                    m_failed = true;
+            }
+            m_len = 0;
+            errno = savedErrno;
+            return !m_failed;
+        }
+
+        int total() const { return m_total; }
+
+    private:
+        int m_fd;
+        char m_buf[256];
+        int m_len;
+        int m_total;
+        bool m_failed;
+};
+
+inline int parseInt(const char*& c)
+{
+    int i = 0;
+    for(; *c >= '0' && *c <= '9'; ++c)
+        i = 10*i + (*c - '0');
+    return i;
+}
+
+// Format a single argument according to the conversion spec
+inline void formatArg(FdWriter& out, const Arg& arg, char conv, bool leftAlign,
+                      bool zeroPad, char signChar, bool alternate, int width,
+                      int precision)
+{
+    char digits[72];
+    const char* body = digits;
+    int bodyLen = 0;
+    const char* prefix = "";
+    int zeros = 0;
+    if(arg.kind() == Arg::String && conv != 'p')
+    {
+        body = arg.str() ? arg.str() : "(null)";
+        while((precision < 0 || bodyLen < precision) && body[bodyLen])
+            ++bodyLen;
+        zeroPad = false;
+    }
+    else if(conv == 'c' || (arg.kind() == Arg::Char && conv == 's'))
+    {
+        digits[0] = static_cast<char>(arg.uintValue());
+        bodyLen = 1;
+        zeroPad = false;
+    }
+    else
+    {
+        unsigned long long value = arg.uintValue();
+        bool isNegative = false;
+        int base = 10;
+        bool upperCase = false;
+        if(conv == 'x' || conv == 'X' || conv == 'p' || arg.kind() == Arg::Pointer)
+        {
+            base = 16;
+            upperCase = conv == 'X';
+            if(conv == 'p' || arg.kind() == Arg::Pointer || (alternate && value != 0))
+                prefix = upperCase ? "0X" : "0x";
+        }
+        else if(conv == 'o')
+            base = 8;
+        else if(arg.kind() == Arg::Signed || arg.kind() == Arg::Char)
+        {
+            long long v = arg.intValue();
+            isNegative = v < 0;
+            value = isNegative ? 0 - static_cast<unsigned long long>(v)
+                               : static_cast<unsigned long long>(v);
+        }
+        if(base == 10)
+            bodyLen = static_cast<int>(tinyformat::detail::writeDecimal(digits, value) - digits);
+        else
+        {
+            const char* hexDigits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+            char* end = digits + sizeof(digits);
+            char* p = end;
+            do
+            {
+                *--p = hexDigits[value % base];
+                value /= base;
+            }
+            while(value != 0);
+            if(base == 8 && alternate && *p != '0')
+                *--p = '0';
+            body = p;
+            bodyLen = static_cast<int>(end - p);
+        }
+        if(base == 10 && (isNegative || signChar))
+            prefix = isNegative ? "-" : (signChar == '+' ? "+" : " ");
+        if(precision >= 0)
+        {
+            zeros = precision > bodyLen ? precision - bodyLen : 0;
+            if(precision == 0 && bodyLen == 1 && body[0] == '0' && conv != 'p')
+                bodyLen = 0;
+            zeroPad = false;
+        }
+    }
+    int prefixLen = static_cast<int>(std::strlen(prefix));
+    int padding = width - prefixLen - zeros - bodyLen;
+    if(padding > 0 && zeroPad && !leftAlign)
+    {
+        zeros += padding;
+        padding = 0;
+    }
+    if(padding > 0 && !leftAlign)
+        out.fill(' ', padding);
+    out.write(prefix, prefixLen);
+    out.fill('0', zeros);
+    out.write(body, bodyLen);
+    if(padding > 0 && leftAlign)
+        out.fill(' ', padding);
+}
+
+inline int vdprintf(int fd, const char* fmt, const Arg* args, int nargs)
+{
+    // A signal handler must not change errno under the interrupted code
+    int savedErrno = errno;
+    FdWriter out(fd);
+    int argIndex = 0;
+    for(const char* c = fmt; *c; ++c)
+    {
+        if(*c != '%')
+        {
+            out.put(*c);
+            continue;
+        }
+        ++c;
+        if(*c == '%')
+        {
+            out.put('%');
+            continue;
+        }
+        bool leftAlign = false;
+        bool zeroPad = false;
+        bool alternate = false;
+        char signChar = 0;
+        for(;; ++c)
+        {
+            if(*c == '-')      leftAlign = true;
+            else if(*c == '0') zeroPad = true;
+            else if(*c == '#') alternate = true;
+            else if(*c == '+') signChar = '+';
+            else if(*c == ' ') { if(signChar != '+') signChar = ' '; }
+            else break;
+        }
+        int width = parseInt(c);
+        int precision = -1;
+        if(*c == '.')
+        {
+            ++c;
+            precision = parseInt(c);
+        }
+        while(*c == 'h' || *c == 'l' || *c == 'L' || *c == 'j' || *c == 'z' || *c == 't')
+            ++c;
+        char conv = *c;
+        if(conv == '\0')
+        {
+            // Incomplete spec at the end of the format string
+            out.write("%!", 2);
+            break;
+        }
+        const Arg* arg = argIndex < nargs ? &args[argIndex++] : 0;
+        if(std::strchr("diuoxXcsp", conv) == 0 ||
+           (conv == 'c' && arg && arg->kind() == Arg::String))
+        {
+            // Unsupported conversion, which consumes its argument as printf
+            // would
+            out.write("%!", 2);
+            out.put(conv);
+            continue;
+        }
+        if(!arg)
+        {
+            out.write("%!", 2);
+            out.put(conv);
+            out.write("(missing)", 9);
+            continue;
+        }
+        formatArg(out, *arg, conv, leftAlign, zeroPad, signChar, alternate,
+                  width, precision);
+    }
+    bool ok = out.flush();
+    errno = savedErrno;
+    return ok ? out.total() : -1;
+}
+
+#ifdef TINYFORMAT_SINKS_CXX11
+// Compile time check of dprintf() format strings.  Arguments are classified
+// as for Arg, as 'i' for integers, 'c' for characters, 's' for C strings and
+// 'p' for other pointers, and each conversion of the format string, parsed
+// as by vdprintf(), must accept the kind of the corresponding argument.
+template<typename T>
+struct ArgKind
+{
+    typedef typename std::remove_cv<typename std::remove_pointer<T>::type>::type Pointee;
+    static constexpr char value =
+        std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+        std::is_same<T, unsigned char>::value ? 'c' :
+        std::is_integral<T>::value ? 'i' :
+        std::is_same<Pointee, char>::value ? 's' :
+        std::is_pointer<T>::value ? 'p' : '?';
+};
+
+template<typename... Args>
+struct ArgKinds
+{
+    static constexpr char value[] = { ArgKind<typename std::decay<Args>::type>::value..., '\0' };
+};
+template<typename... Args>
+constexpr char ArgKinds<Args...>::value[];
+
+template<typename... Args>
+ArgKinds<Args...> argKinds(const char* fmt, const Args&... args);
+
+constexpr bool isOneOf(char c, const char* set)
+{
+    return *set != '\0' && (*set == c || isOneOf(c, set + 1));
+}
+
+constexpr const char* skipOneOf(const char* c, const char* set)
+{
+    return isOneOf(*c, set) ? skipOneOf(c + 1, set) : c;
+}
+
+constexpr const char* skipPrecision(const char* c)
+{
+    return *c == '.' ? skipOneOf(c + 1, "0123456789") : c;
+}
+
+// Skip the flags, width, precision and length of a spec
+constexpr const char* findConversion(const char* c)
+{
+    return skipOneOf(skipPrecision(skipOneOf(skipOneOf(c, "-0#+ "), "0123456789")),
+                     "hlLjzt");
+}
+
+constexpr bool convAccepts(char conv, char kind)
+{
+    return conv == 's' ? kind != '?' :
+           conv == 'p' ? kind == 'p' || kind == 's' :
+           isOneOf(conv, "diuoxXc") && (kind == 'i' || kind == 'c');
+}
+
+constexpr bool checkFormat(const char* c, const char* kinds);
+
+constexpr bool checkConversion(const char* conv, const char* kinds)
+{
+    return *kinds != '\0' && convAccepts(*conv, *kinds) &&
+           checkFormat(conv + 1, kinds + 1);
+}
+
+constexpr bool checkFormat(const char* c, const char* kinds)
+{
+    return *c == '\0' ? *kinds == '\0' :
+           *c != '%'  ? checkFormat(c + 1, kinds) :
+           c[1] == '%' ? checkFormat(c + 2, kinds) :
+           checkConversion(findConversion(c + 1), kinds);
+}
+
+template<bool formatOk>
+struct CheckedFormat
+{
+    static_assert(formatOk, "tinyformat: Unsupported conversion or argument "
+                  "mismatch in signal_safe::dprintf() format string");
+
+    template<typename... Args>
+    static int dprintf(int fd, const char* fmt, const Args&... args);
+};
+#endif // TINYFORMAT_SINKS_CXX11
+
+} // namespace detail
+
+
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+
+/// Format onto file descriptor fd using only async-signal-safe operations.
+/// Returns the number of bytes written, or -1 if writing fails.  errno is
+/// preserved in either case.
+template<typename... Args>
+int dprintf(int fd, const char* fmt, const Args&... args)
+{
+    const detail::Arg argArray[] = { detail::Arg(args)..., detail::Arg(0) };
+    return detail::vdprintf(fd, fmt, argArray, sizeof...(args));
+}
+
+#else // C++98 version
+
+inline int dprintf(int fd, const char* fmt)
+{
+    return detail::vdprintf(fd, fmt, 0, 0);
+}
+
+#define TINYFORMAT_MAKE_SIGNAL_SAFE_DPRINTF(n)                            \
+template<TINYFORMAT_ARGTYPES(n)>                                          \
+int dprintf(int fd, const char* fmt, TINYFORMAT_VARARGS(n))               \
+{                                                                         \
+    const detail::Arg argArray[] = { TINYFORMAT_PASSARGS(n) };            \
+    return detail::vdprintf(fd, fmt, argArray, n);                        \
+}
+TINYFORMAT_FOREACH_ARGNUM(TINYFORMAT_MAKE_SIGNAL_SAFE_DPRINTF)
+#undef TINYFORMAT_MAKE_SIGNAL_SAFE_DPRINTF
+
+#endif
+
+#ifdef TINYFORMAT_SINKS_CXX11
+template<bool formatOk>
+template<typename... Args>
+int detail::CheckedFormat<formatOk>::dprintf(int fd, const char* fmt,
+                                             const Args&... args)
+{
+    return signal_safe::dprintf(fd, fmt, args...);
+}
+#endif
+
+} // namespace signal_safe
+
+#ifdef TINYFORMAT_SINKS_CXX11
+/// signal_safe::dprintf(fd, fmt, ...) with the literal format string fmt
+/// checked at compile time
+#define TINYFORMAT_SIGNAL_SAFE_DPRINTF(fd, ...)                                \
+    tinyformat::signal_safe::detail::CheckedFormat<                            \
+        tinyformat::signal_safe::detail::checkFormat(                          \
+            TINYFORMAT_SIGNAL_SAFE_FORMAT_STRING(__VA_ARGS__, 0),              \
+            decltype(tinyformat::signal_safe::detail::argKinds(__VA_ARGS__))::value) \
+    >::dprintf(fd, __VA_ARGS__)
+#define TINYFORMAT_SIGNAL_SAFE_FORMAT_STRING(fmt, ...) fmt
+#endif
+
+#endif // TINYFORMAT_SINKS_POSIX
+
+
+#ifdef TINYFORMAT_SINKS_CXX11
+
+//------------------------------------------------------------------------------
+// Deferred arguments: copies of argument values with their ArgType tags,
+// which can be formatted later, after the original arguments are gone.
+namespace detail {
+
+// Number of bytes used to store an argument in deferred form, not including
+// the tag byte, or -1 if it can't be stored.
+inline long deferredArgSize(const FormatArg& arg)
+{
+    const void* v = arg.value();
+    switch(arg.type())
+    {
+        case ArgOther:
+            return -1;
+        case ArgCString:
+        {
+            const char* str = *static_cast<const char* const*>(v);
+            return str ? 4 + std::strlen(str) + 1 : -1;
+        }
+        case ArgCharArray:
+            return 4 + charArrayLength(arg) + 1;
+        case ArgStdString:
+            return 4 + static_cast<const std::string*>(v)->size() + 1;
+        default:
+            return scalarArgSize(arg.type());
+    }
+}
+
+// Store string with 32 bit length prefix and terminating null, truncating it
+// if necessary to fit before end.
+inline char* putDeferredString(char* p, char* end, const char* str, size_t len)
+{
+    if(end - p < 5)
+        return 0;
+    if(len > static_cast<size_t>(end - p - 5))
+        len = end - p - 5;
+    std::uint32_t len32 = static_cast<std::uint32_t>(len);
+    std::memcpy(p, &len32, 4);
+    std::memcpy(p + 4, str, len);
+    p[4 + len] = '\0';
+    return p + 4 + len + 1;
+}
+
+// Store the arguments in list as a sequence of tag bytes and values in the
+// space from p to end.  Strings are truncated if necessary.  Returns one past
+// the end of the stored arguments, or null if they can't be stored.
+inline char* putDeferredArgs(char* p, char* end, FormatListRef list)
+{
+    for(int i = 0; i < list.size() && p; ++i)
+    {
+        const FormatArg& arg = list.arg(i);
+        long n = deferredArgSize(arg);
+        // Strings need at least room for their length and null terminator
+        bool isString = arg.type() == ArgCString || arg.type() == ArgCharArray ||
+                        arg.type() == ArgStdString;
+        if(n < 0 || end - p < 1 + (isString ? 5 : n))
+            return 0;
+        *p++ = static_cast<char>(arg.type());
+        switch(arg.type())
+        {
+            case ArgCString:
+            {
+                const char* str = *static_cast<const char* const*>(arg.value());
+                p = putDeferredString(p, end, str, std::strlen(str));
+                break;
+            }
+            case ArgCharArray:
+            {
+                const char* str = static_cast<const char*>(arg.value());
+                p = putDeferredString(p, end, str, charArrayLength(arg));
+                break;
+            }
+            case ArgStdString:
+            {
+                const std::string* str = static_cast<const std::string*>(arg.value());
+                p = putDeferredString(p, end, str->data(), str->size());
+                break;
+            }
+            default:
+                std::memcpy(p, arg.value(), n);
+                p += n;
+                break;
+        }
+    }
+    return p;
+}
+
+// Storage for a decoded deferred argument
+struct DeferredValue
+{
+    union
+    {
+        bool b; char c; signed char sc; unsigned char uc;
+        short s; unsigned short us; int i; unsigned int ui;
+        long l; unsigned long ul; long long ll; unsigned long long ull;
+        float f; double d; long double ld;
+        const char* str; const void* ptr;
+    };
+};
+
+inline const char* getDeferredString(const char*& p)
+{
+    std::uint32_t len;
+    std::memcpy(&len, p, 4);
+    const char* str = p + 4;
+    p += 4 + len + 1;
+    return str;
+}
+
+template<typename T>
+inline void getDeferredValue(const char*& p, T& value)
+{
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+}
+
+// Decode nargs arguments stored by putDeferredArgs() into values, and set up
+// args to refer to them.
+inline void getDeferredArgs(const char* p, int nargs, DeferredValue* values,
+                            FormatArg* args)
+{
+    for(int i = 0; i < nargs; ++i)
+    {
+        DeferredValue& v = values[i];
+        switch(*p++)
+        {
+#           define TINYFORMAT_GET_DEFERRED_ARG(tag, member)                 \
+            case tag:                                                      \
+                getDeferredValue(p, v.member);                             \
+                args[i] = FormatArg(v.member);                             \
+                break;
+            TINYFORMAT_GET_DEFERRED_ARG(ArgBool, b)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgChar, c)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgSChar, sc)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgUChar, uc)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgShort, s)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgUShort, us)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgInt, i)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgUInt, ui)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgLong, l)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgULong, ul)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgLongLong, ll)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgULongLong, ull)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgFloat, f)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgDouble, d)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgLongDouble, ld)
+            TINYFORMAT_GET_DEFERRED_ARG(ArgPointer, ptr)
+#           undef TINYFORMAT_GET_DEFERRED_ARG
+            default:
+                // Strings of all types
+                v.str = getDeferredString(p);
+                args[i] = FormatArg(v.str);
+                break;
+        }
+    }
+}
+
+} // namespace detail
+
+#endif // TINYFORMAT_SINKS_CXX11
+
+
+#ifdef TINYFORMAT_SINKS_SHM_RING
+
+
+//------------------------------------------------------------------------------
+/// Lock free log ring in POSIX shared memory, with any number of producer
+/// processes and a single consumer.
+///
+/// A collector process creates the ring and drains it; worker processes open
+/// it by name and log into it.  When all arguments of a message have built in
+/// types, the producer just copies the format string and argument values into
+/// the ring, tagged with their types, and formatting happens in the consumer.
+/// Other messages are formatted by the producer.  A message which doesn't fit
+/// in the free space is dropped and counted rather than blocking the
+/// producer.
+///
+///   // collector
+///   tfm::ShmLogRing ring;
+///   ring.create("/myapp-log", 1 << 20);
+///   for(;;) { ring.drain(logFile); usleep(1000); }
+///
+///   // worker
+///   tfm::ShmLogRing ring;
+///   ring.open("/myapp-log");
+///   ring.log("job %d finished in %.3fs", jobId, seconds);
+///
+/// Since format strings are copied into the ring, deferred records don't
+/// depend on the address layout of the producer.  A producer which dies
+/// between reserving space and completing a record stalls the consumer at
+/// that record.  On older glibc versions, link with -lrt.
+class ShmLogRing
+{
+    public:
+        ShmLogRing() : m_map(0), m_mapSize(0), m_header(0), m_data(0) { }
+        ~ShmLogRing() { close(); }
+
+        /// Create shared memory object `name` (for example "/myapp-log")
+        /// holding capacity bytes of records, replacing any existing ring of
+        /// the same name.  Returns false on failure.
+        bool create(const char* name, size_t capacity)
+        {
+            close();
+            capacity = (capacity + 15) & ~size_t(15);
+            ::shm_unlink(name);
+            int fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+            if(fd < 0)
+                return false;
+            size_t mapSize = sizeof(Header) + capacity;
+            bool ok = ::ftruncate(fd, mapSize) == 0 && map(fd, mapSize);
+            ::close(fd);
+            if(!ok)
+            {
+                ::shm_unlink(name);
+                return false;
+            }
+            // The new object is zero filled, which is the empty state of all
+            // records.
+            m_header = new (m_map) Header();
+            m_header->capacity = capacity;
+            m_header->magic.store(magicValue, std::memory_order_release);
+            return true;
+        }
+
+        /// Open an existing ring created with create().  Returns false if it
+        /// doesn't exist or isn't initialized yet.
+        bool open(const char* name)
+        {
+            close();
+            int fd = ::shm_open(name, O_RDWR, 0);
+            if(fd < 0)
+                return false;
+            struct stat st;
+            bool ok = ::fstat(fd, &st) == 0 &&
+                      static_cast<size_t>(st.st_size) > sizeof(Header) &&
+                      map(fd, st.st_size);
+            ::close(fd);
+            if(!ok)
+                return false;
+            m_header = static_cast<Header*>(m_map);
+            if(m_header->magic.load(std::memory_order_acquire) != magicValue ||
+               m_header->capacity != m_mapSize - sizeof(Header))
+            {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        /// Unmap the ring.  The shared memory object remains until unlink().
+        void close()
+        {
+            if(m_map)
+                ::munmap(m_map, m_mapSize);
+            m_map = 0;
+            m_mapSize = 0;
+            m_header = 0;
+            m_data = 0;
+        }
+
+        /// Remove the shared memory object `name`
+        static bool unlink(const char* name)
+        {
+            return ::shm_unlink(name) == 0;
+        }
+
+        bool isOpen() const { return m_header != 0; }
+
+        //----------------------------------------------------------------------
+        // Producer interface; safe to use concurrently from any number of
+        // threads and processes.
+
+        /// Append already formatted text as a record
+        bool write(const char* text, size_t len)
+        {
+            Record* r = reserve(len);
+            if(!r)
+                return false;
+            r->kind = TextRecord;
+            r->nargs = 0;
+            std::memcpy(payloadOf(r), text, len);
+            commit(r, len);
+            return true;
+        }
+
+        /// Append a message, deferring formatting to the consumer if possible
+        bool vlog(const char* fmt, FormatListRef list)
+        {
+            size_t fmtLen = std::strlen(fmt);
+            size_t payload = 4 + fmtLen + 1;
+            for(int i = 0; i < list.size(); ++i)
+            {
+                long n = detail::deferredArgSize(list.arg(i));
+                if(n < 0)
+                {
+                    detail::SmallStreamBuf<512> buf;
+                    std::ostream out(&buf);
+                    vformat(out, fmt, list);
+                    return write(buf.data(), buf.size());
+                }
+                payload += 1 + n;
+            }
+            Record* r = reserve(payload);
+            if(!r)
+                return false;
+            r->kind = DeferredRecord;
+            r->nargs = static_cast<std::uint16_t>(list.size());
+            char* p = payloadOf(r);
+            char* end = p + payload;
+            p = detail::putDeferredString(p, end, fmt, fmtLen);
+            detail::putDeferredArgs(p, end, list);
+            commit(r, payload);
+            return true;
+        }
+
+        template<typename... Args>
+        bool log(const char* fmt, const Args&... args)
+        {
+            return vlog(fmt, makeFormatList(args...));
+        }
+
+        //----------------------------------------------------------------------
+        // Consumer interface; only one consumer may use the ring at a time.
+
+        /// Format the next record onto out.  Returns false if there's no
+        /// complete record available.
+        bool read(std::ostream& out)
+        {
+            Record* r = next();
+            if(!r)
+                return false;
+            std::uint32_t payload = r->payload;
+            const char* p = payloadOf(r);
+            if(r->kind == TextRecord)
+                out.write(p, payload);
+            else
+                formatDeferred(out, p, r->nargs);
+            release(r);
+            return true;
+        }
+
+        /// Format all available records onto out, each followed by a newline.
+        /// Returns the number of records read.
+        size_t drain(std::ostream& out)
+        {
+            size_t count = 0;
+            while(read(out))
+            {
+                out.put('\n');
+                ++count;
+            }
+            return count;
+        }
+
+        /// Number of messages dropped because the ring was full
+        unsigned long long dropped() const
+        {
+            return m_header->dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // Noncopyable
+        ShmLogRing(const ShmLogRing&);
+        ShmLogRing& operator=(const ShmLogRing&);
+
+        static const std::uint32_t magicValue = 0x74666d72;  // "tfmr"
+
+        enum RecordKind { PaddingRecord, TextRecord, DeferredRecord };
+
+        // Shared header at the start of the mapping.  The producer and
+        // consumer positions count bytes written since creation, and live on
+        // separate cache lines.
+        struct Header
+        {
+            std::atomic<std::uint32_t> magic;
+            std::uint64_t capacity;
+            alignas(64) std::atomic<std::uint64_t> head;
+            alignas(64) std::atomic<std::uint64_t> tail;
+            std::atomic<std::uint64_t> dropped;
+        };
+
+        // Atomics in memory shared between processes must not rely on a lock
+        // held by one process, so they must be lock free
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                      "tinyformat: ShmLogRing needs lock free 32 and 64 bit atomics");
+
+        // Record header, followed by the payload and padding to a multiple of
+        // sixteen bytes, so the end of the buffer always has room for a
+        // padding record.  size is the total record size, and is zero until
+        // the record is complete.
+        struct Record
+        {
+            std::atomic<std::uint32_t> size;
+            std::uint32_t payload;
+            std::uint16_t kind;
+            std::uint16_t nargs;
+            std::uint32_t reserved;
+        };
+
+        bool map(int fd, size_t size)
+        {
+            void* p = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(p == MAP_FAILED)
+                return false;
+            m_map = p;
+            m_mapSize = size;
+            m_data = static_cast<char*>(p) + sizeof(Header);
+            return true;
+        }
+
+        static char* payloadOf(Record* r)
+        {
+            return reinterpret_cast<char*>(r) + sizeof(Record);
+        }
+
+        Record* recordAt(std::uint64_t pos) const
+        {
+            return reinterpret_cast<Record*>(m_data + pos % m_header->capacity);
+        }
+
+        // Claim space for a record with the given payload size, or return
+        // null if there isn't enough free space.  When the record would run
+        // past the end of the buffer, the remainder of the buffer is claimed
+        // as well and filled with a padding record.
+        Record* reserve(size_t payload)
+        {
+            std::uint64_t capacity = m_header->capacity;
+            std::uint64_t size = (sizeof(Record) + payload + 15) & ~std::uint64_t(15);
+            std::uint64_t head = m_header->head.load(std::memory_order_relaxed);
+            std::uint64_t skip = 0;
+            for(;;)
+            {
+                std::uint64_t offset = head % capacity;
+                skip = offset + size > capacity ? capacity - offset : 0;
+                std::uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+                if(head + skip + size - tail > capacity)
+                {
+                    m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return 0;
+                }
+                if(m_header->head.compare_exchange_weak(head, head + skip + size,
+                                                        std::memory_order_relaxed))
+                    break;
+            }
+            if(skip)
+            {
+                Record* pad = recordAt(head);
+                pad->kind = PaddingRecord;
+                pad->size.store(static_cast<std::uint32_t>(skip), std::memory_order_release);
+            }
+            Record* r = recordAt(head + skip);
+            r->payload = static_cast<std::uint32_t>(payload);
+            return r;
+        }
+
+        static void commit(Record* r, size_t payload)
+        {
+            std::uint32_t size = (sizeof(Record) + payload + 15) & ~std::uint32_t(15);
+            r->size.store(size, std::memory_order_release);
+        }
+
+        // Return the next complete record, skipping padding, or null
+        Record* next()
+        {
+            for(;;)
+            {
+                std::uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+                if(tail == m_header->head.load(std::memory_order_acquire))
+                    return 0;
+                Record* r = recordAt(tail);
+                if(r->size.load(std::memory_order_acquire) == 0)
+                    return 0;
+                if(r->kind != PaddingRecord)
+                    return r;
+                release(r);
+            }
+        }
+
+        // Zero the record, ready for reuse, and pass it back to producers
+        void release(Record* r)
+        {
+            std::uint32_t size = r->size.load(std::memory_order_relaxed);
+            std::memset(reinterpret_cast<char*>(r) + sizeof(r->size), 0,
+                        size - sizeof(r->size));
+            r->size.store(0, std::memory_order_relaxed);
+            m_header->tail.fetch_add(size, std::memory_order_release);
+        }
+
+        static void formatDeferred(std::ostream& out, const char* p, int nargs)
+        {
+            const char* fmt = detail::getDeferredString(p);
+            std::vector<detail::DeferredValue> values(nargs);
+            std::vector<detail::FormatArg> args(nargs);
+            if(nargs)
+                detail::getDeferredArgs(p, nargs, &values[0], &args[0]);
+            vformat(out, fmt, FormatList(nargs ? &args[0] : 0, nargs));
+        }
+
+        void* m_map;
+        size_t m_mapSize;
+        Header* m_header;
+        char* m_data;
+};
+
+#endif // TINYFORMAT_SINKS_SHM_RING
+
+
+#ifdef TINYFORMAT_SINKS_CXX11
+
+#ifndef TINYFORMAT_FLIGHT_RECORDER_THREADS
+#   define TINYFORMAT_FLIGHT_RECORDER_THREADS 64
+#endif
+#ifndef TINYFORMAT_FLIGHT_RECORDER_RECORDS
+#   define TINYFORMAT_FLIGHT_RECORDER_RECORDS 256
+#endif
+
+//------------------------------------------------------------------------------
+/// In-memory flight recorder of the most recent messages of each thread.
+///
+/// record() keeps a message in a fixed size ring owned by the calling thread,
+/// overwriting the oldest one.  Messages aren't formatted when recorded: the
+/// format string pointer is stored along with copies of the argument values
+/// and their type tags, so recording is cheap enough to do for every message
+/// regardless of log level.  Messages with arguments of types other than the
+/// built in arithmetic, void* and string types are formatted when recorded.
+///
+///   template<typename... Args>
+///   void logDebug(const char* fmt, const Args&... args)
+///   {
+///       tfm::FlightRecorder::record(fmt, args...);
+///       if(g_debug)
+///           tfm::printfln(fmt, args...);
+///   }
+///
+/// dump() formats the recorded messages of all threads in timestamp order.
+/// The rings live in static storage, so nothing is allocated after a
+/// thread's first message, and the rings of exited threads are kept until
+/// reused by a new thread once no empty ring is left.  The number of
+/// threads and messages per thread are set with
+/// TINYFORMAT_FLIGHT_RECORDER_THREADS (default 64) and
+/// TINYFORMAT_FLIGHT_RECORDER_RECORDS (default 256); threads beyond the
+/// limit aren't recorded.
+///
+/// Format strings must remain valid until dumped, as string literals do.
+/// Each record holds 96 bytes of argument data; longer string arguments are
+/// truncated.
+class FlightRecorder
+{
+    public:
+        static const int maxThreads = TINYFORMAT_FLIGHT_RECORDER_THREADS;
+        static const int recordsPerThread = TINYFORMAT_FLIGHT_RECORDER_RECORDS;
+
+        /// Record a message for the calling thread
+        static void vrecord(const char* fmt, FormatListRef list)
+        {
+            Ring* ring = threadRing();
+            if(!ring)
+                return;
+            std::uint64_t index = ring->count.load(std::memory_order_relaxed);
+            Record& r = ring->records[index % recordsPerThread];
+            // Sequence lock: the version is odd while the record is written
+            std::uint32_t version = r.version.load(std::memory_order_relaxed);
+            r.version.store(version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            r.index = index;
+            r.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            if(detail::putDeferredArgs(r.args, r.args + sizeof(r.args), list))
+            {
+                r.fmt = fmt;
+                r.nargs = list.size();
+            }
+            else
+            {
+                // Store the formatted text instead
+                r.fmt = 0;
+                r.nargs = 0;
+                vformatToBuffer(r.args, sizeof(r.args), fmt, list);
+            }
+            r.version.store(version + 2, std::memory_order_release);
+            ring->count.store(index + 1, std::memory_order_release);
+        }
+
+        template<typename... Args>
+        static void record(const char* fmt, const Args&... args)
+        {
+            vrecord(fmt, makeFormatList(args...));
+        }
+
+#ifdef TINYFORMAT_STREAM_API
+        /// Format the recorded messages of all threads onto out in timestamp
+        /// order.  Each line has the UTC time, the thread's ring number and
+        /// the message.
+        static void dump(std::ostream& out)
+        {
+            dumpTo(&writeToStream, &out);
+        }
+#endif
+
+#ifdef TINYFORMAT_SINKS_POSIX
+        /// Write the recorded messages to file descriptor fd, as for
+        /// dump(std::ostream&).  Lines are built in a stack buffer and
+        /// written with write(2), so the recorder itself takes no lock and
+        /// allocates nothing, which makes this usable as a best effort from
+        /// a crash handler.  Formatting still constructs a std::ostream,
+        /// though; copying the global std::locale may take a mutex in the
+        /// standard library, and iostreams aren't async-signal-safe.
+        static void dump(int fd)
+        {
+            dumpTo(&writeToFd, &fd);
+        }
+#endif
+
+        /// Discard all recorded messages.  Must not be called while other
+        /// threads are recording.
+        static void clear()
+        {
+            Ring* r = rings();
+            for(int i = 0; i < maxThreads; ++i)
+            {
+                for(int j = 0; j < recordsPerThread; ++j)
+                    r[i].records[j].index = ~std::uint64_t(0);
+                r[i].count.store(0, std::memory_order_release);
+            }
+        }
+
+    private:
+        static const int argBytes = 96;
+
+        struct Record
+        {
+            std::atomic<std::uint32_t> version;
+            int nargs;
+            std::uint64_t index;
+            long long timestamp;  // microseconds since the epoch
+            const char* fmt;      // null if args holds formatted text
+            char args[argBytes];
+        };
+
+        // Consistent copy of a record
+        struct RecordCopy
+        {
+            long long timestamp;
+            const char* fmt;
+            int nargs;
+            char args[argBytes];
+        };
+
+        struct Ring
+        {
+            std::atomic<bool> inUse;
+            std::atomic<std::uint64_t> count;
+            Record records[recordsPerThread];
+        };
+
+        // Claim on a ring by the current thread, released on thread exit.
+        // Empty rings are preferred, so that the messages of exited threads
+        // are only overwritten once every ring has been used.
+        struct RingClaim
+        {
+            Ring* ring;
+
+            RingClaim() : ring(0)
+            {
+                Ring* r = rings();
+                for(int pass = 0; pass < 2 && !ring; ++pass)
+                {
+                    for(int i = 0; i < maxThreads && !ring; ++i)
+                    {
+                        if(pass == 0 && r[i].count.load(std::memory_order_relaxed) != 0)
+                            continue;
+                        bool expected = false;
+                        if(r[i].inUse.compare_exchange_strong(expected, true))
+                            ring = &r[i];
+                    }
+                }
+            }
+
+            ~RingClaim()
+            {
+                if(ring)
+                    ring->inUse.store(false, std::memory_order_release);
+            }
+        };
+
+        // Rings in static storage, which is zero initialized
+        static Ring* rings()
+        {
+            static Ring r[maxThreads];
+            return r;
+        }
+
+        static Ring* threadRing()
+        {
+            static thread_local RingClaim claim;
+            return claim.ring;
+        }
+
+        // Read record number index of ring, if it hasn't been overwritten
+        // and isn't being written.
+        static bool readRecord(const Ring& ring, std::uint64_t index,
+                               RecordCopy* copy, long long* timestamp)
+        {
+            const Record& r = ring.records[index % recordsPerThread];
+            std::uint32_t version = r.version.load(std::memory_order_acquire);
+            if(version & 1)
+                return false;
+            *timestamp = r.timestamp;
+            bool ok = r.index == index;
+            if(copy)
+            {
+                copy->timestamp = r.timestamp;
+                copy->fmt = r.fmt;
+                copy->nargs = r.nargs;
+                std::memcpy(copy->args, r.args, sizeof(copy->args));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return ok && r.version.load(std::memory_order_relaxed) == version;
+        }
+
+        static void dumpTo(void (*write)(void*, const char*, size_t), void* context)
+        {
+            Ring* r = rings();
+            std::uint64_t next[maxThreads];
+            std::uint64_t end[maxThreads];
+            for(int i = 0; i < maxThreads; ++i)
+            {
+                end[i] = r[i].count.load(std::memory_order_acquire);
+                next[i] = end[i] > recordsPerThread ? end[i] - recordsPerThread : 0;
+            }
+            for(;;)
+            {
+                // Merge the rings by choosing the earliest next record
+                int best = -1;
+                long long bestTime = 0;
+                for(int i = 0; i < maxThreads; ++i)
+                {
+                    long long t = 0;
+                    while(next[i] < end[i] && !readRecord(r[i], next[i], 0, &t))
+                        ++next[i];
+                    if(next[i] < end[i] && (best < 0 || t < bestTime))
+                    {
+                        best = i;
+                        bestTime = t;
+                    }
+                }
+                if(best < 0)
+                    break;
+                RecordCopy copy;
+                long long t = 0;
+                if(readRecord(r[best], next[best]++, &copy, &t))
+                    writeRecord(write, context, best, copy);
+            }
+        }
+
+        static void writeRecord(void (*write)(void*, const char*, size_t),
+                                void* context, int ringIndex, const RecordCopy& r)
+        {
+            char line[512];
+            long long seconds = r.timestamp / 1000000;
+            long micros = static_cast<long>(r.timestamp % 1000000);
+            char* p = detail::writeUtcDateTime(line, seconds);
+            *p++ = '.';
+            p = detail::writeFixedDecimal(p, micros, 6);
+            *p++ = ' ';
+            *p++ = '[';
+            p = tinyformat::detail::writeDecimal(p, ringIndex);
+            *p++ = ']';
+            *p++ = ' ';
+            size_t avail = line + sizeof(line) - p - 1;
+            size_t len = 0;
+            if(!r.fmt)
+            {
+                len = std::strlen(r.args);
+                std::memcpy(p, r.args, len);
+            }
+            else
+            {
+                // Each stored argument takes at least two bytes
+                detail::DeferredValue values[argBytes/2];
+                detail::FormatArg args[argBytes/2];
+                detail::getDeferredArgs(r.args, r.nargs, values, args);
+                len = vformatToBuffer(p, avail + 1, r.fmt,
+                                      FormatList(args, r.nargs));
+                if(len > avail)
+                    len = avail;
+            }
+            p += len;
+            *p++ = '\n';
+            write(context, line, p - line);
+        }
+
+#ifdef TINYFORMAT_STREAM_API
+        static void writeToStream(void* out, const char* s, size_t n)
+        {
+            static_cast<std::ostream*>(out)->write(s, n);
+        }
+#endif
+
+#ifdef TINYFORMAT_SINKS_POSIX
+        static void writeToFd(void* fd, const char* s, size_t n)
+        {
+            while(n > 0)
+            {
+                ssize_t written = ::write(*static_cast<int*>(fd), s, n);
+                if(written < 0 && errno == EINTR)
+                    continue;
+                if(written <= 0)
+                    return;
+                s += written;
+                n -= written;
+            }
+        }
+#endif
+};
+
+#endif // TINYFORMAT_SINKS_CXX11
+
+
+} // namespace tinyformat
+
+#ifdef TINYFORMAT_SUPPRESS_LONG_LONG_WARNINGS
+#   pragma GCC diagnostic pop
+#endif
+
+#endif // TINYFORMAT_SINKS_H_INCLUDED
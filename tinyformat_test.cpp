@@ -8,13 +8,91 @@ namespace std { class type_info; }
 #include <climits>
 #include <cfloat>
 #include <cstddef>
+#include <locale>
 
 // Throw instead of abort() so we can test error conditions.
 #define TINYFORMAT_ERROR(reason) \
     throw std::runtime_error(reason);
 
 #include "tinyformat.h"
+#include "tinyformat_sinks.h"
 #include <cassert>
+#ifdef TINYFORMAT_SINKS_CXX11
+#   include <thread>
+#endif
+
+#ifdef TINYFORMAT_NO_HEAP
+// The functions returning std::string aren't declared with
+// TINYFORMAT_NO_HEAP.  Define them here on top of the stream versions, which
+// the no_heap builds of this file enable with TINYFORMAT_NO_HEAP_STREAMS, so
+// that the same tests check the fixed buffer code paths.  The strict mode is
+// tested by tinyformat_no_heap_test.cpp.
+namespace tinyformat {
+inline std::string vformatString(const char* fmt, FormatListRef list)
+{
+    std::ostringstream oss;
+    vformat(oss, fmt, list);
+    return oss.str();
+}
+inline std::string vformatBracesString(const char* fmt, FormatListRef list)
+{
+    std::ostringstream oss;
+    vformatBraces(oss, fmt, list);
+    return oss.str();
+}
+inline std::string vcat(FormatListRef list)
+{
+    std::ostringstream oss;
+    vcatTo(oss, list);
+    return oss.str();
+}
+#ifdef TINYFORMAT_USE_VARIADIC_TEMPLATES
+template<typename... Args>
+std::string format(const char* fmt, const Args&... args)
+{
+    return vformatString(fmt, makeFormatList(args...));
+}
+template<typename... Args>
+std::string formatBraces(const char* fmt, const Args&... args)
+{
+    return vformatBracesString(fmt, makeFormatList(args...));
+}
+template<typename... Args>
+std::string cat(const Args&... args)
+{
+    return vcat(makeFormatList(args...));
+}
+#else
+inline std::string format(const char* fmt)
+{
+    return vformatString(fmt, makeFormatList());
+}
+inline std::string formatBraces(const char* fmt)
+{
+    return vformatBracesString(fmt, makeFormatList());
+}
+inline std::string cat() { return std::string(); }
+#define TEST_MAKE_STRING_FUNCS(n)                                           \
+template<TINYFORMAT_ARGTYPES(n)>                                            \
+std::string format(const char* fmt, TINYFORMAT_VARARGS(n))                  \
+{                                                                           \
+    return vformatString(fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));      \
+}                                                                           \
+template<TINYFORMAT_ARGTYPES(n)>                                            \
+std::string formatBraces(const char* fmt, TINYFORMAT_VARARGS(n))            \
+{                                                                           \
+    return vformatBracesString(fmt, makeFormatList(TINYFORMAT_PASSARGS(n)));\
+}                                                                           \
+template<TINYFORMAT_ARGTYPES(n)>                                            \
+std::string cat(TINYFORMAT_VARARGS(n))                                      \
+{                                                                           \
+    return vcat(makeFormatList(TINYFORMAT_PASSARGS(n)));                    \
+}
+TINYFORMAT_FOREACH_ARGNUM(TEST_MAKE_STRING_FUNCS)
+#undef TEST_MAKE_STRING_FUNCS
+#endif
+} // namespace tinyformat
+#endif
 
 #if 0
 // Compare result of tfm::format() to C's sprintf().
@@ -83,6 +161,15 @@ struct TestExceptionDef : public std::runtime_error
 };
 
 
+// Type whose operator<< puts the stream into a failed state
+struct FailingValue {};
+
+std::ostream& operator<<(std::ostream& os, const FailingValue&) {
+    os.setstate(std::ios::failbit);
+    return os;
+}
+
+
 struct MyInt {
 public:
     MyInt(int value) : m_value(value) {}
@@ -97,6 +184,66 @@ std::ostream& operator<<(std::ostream& os, const MyInt& obj) {
 }
 
 
+// Type which counts how often it has been formatted
+struct MyCountingInt
+{
+    MyCountingInt() : m_count(0) {}
+    int timesFormatted() const { return m_count; }
+    mutable int m_count;
+};
+
+std::ostream& operator<<(std::ostream& os, const MyCountingInt& obj) {
+    os << ++obj.m_count;
+    return os;
+}
+
+
+// Type formatted through a pointer by a user operator<<
+struct Node { const char* name; };
+
+std::ostream& operator<<(std::ostream& os, const Node* node) {
+    os << "Node(" << node->name << ")";
+    return os;
+}
+
+
+// Type with no operator<<
+struct Opaque { int x; };
+
+// Numeric punctuation of locales which use a decimal comma
+struct CommaDecimalPoint : std::numpunct<char>
+{
+    char do_decimal_point() const { return ','; }
+};
+
+
+// Aggregates formatted field by field
+namespace testfields {
+struct Point { int x; int y; };
+TINYFORMAT_FORMAT_FIELDS(Point, (x)(y))
+
+struct Order { int id; std::string symbol; double price; Point where; };
+TINYFORMAT_FORMAT_FIELDS(Order, (id)(symbol)(price)(where))
+}
+
+
+#ifdef TINYFORMAT_USE_SOCKADDR
+// Build an IPv6 socket address from eight 16 bit groups
+sockaddr_in6 makeSockaddrIn6(const unsigned short groups[8], unsigned short port)
+{
+    sockaddr_in6 addr;
+    std::memset(&addr, 0, sizeof(addr));
+    for(int i = 0; i < 8; ++i)
+    {
+        addr.sin6_addr.s6_addr[2*i] = static_cast<unsigned char>(groups[i] >> 8);
+        addr.sin6_addr.s6_addr[2*i+1] = static_cast<unsigned char>(groups[i]);
+    }
+    addr.sin6_port = htons(port);
+    return addr;
+}
+#endif
+
+
 int unitTests()
 {
     int nfailed = 0;
@@ -160,6 +307,11 @@ int unitTests()
     CHECK_EQUAL(tfm::format("%.f", 10.1), "10");
     CHECK_EQUAL(tfm::format("%.2s", "asdf"), "as"); // strings truncate to precision
     CHECK_EQUAL(tfm::format("%.2s", std::string("asdf")), "as");
+    CHECK_EQUAL(tfm::format("%5.2s|", "asdf"), "   as|");
+    CHECK_EQUAL(tfm::format("%-5.2s|", std::string("asdf")), "as   |");
+    // Truncated strings are padded to the field width
+    const char asdfArray[] = "asdf";
+    CHECK_EQUAL(tfm::format("%5.2s|%-4.3s|", asdfArray, 12345), "   as|123 |");
 //    // Test variable precision & width
     CHECK_EQUAL(tfm::format("%*.4f", 10, 1234.1234567890), " 1234.1235");
     CHECK_EQUAL(tfm::format("%10.*f", 4, 1234.1234567890), " 1234.1235");
@@ -243,6 +395,875 @@ int unitTests()
     MyInt myobj(42);
     CHECK_EQUAL(tfm::format("myobj: %s", myobj), "myobj: 42");
 
+#   ifdef TINYFORMAT_USE_SOCKADDR
+    // Test socket address formatting
+    sockaddr_in sa4;
+    std::memset(&sa4, 0, sizeof(sa4));
+    const unsigned char ip4[4] = {192, 0, 2, 255};
+    std::memcpy(&sa4.sin_addr, ip4, 4);
+    sa4.sin_port = htons(8080);
+    CHECK_EQUAL(tfm::format("%s", sa4.sin_addr), "192.0.2.255");
+    CHECK_EQUAL(tfm::format("%s", sa4), "192.0.2.255:8080");
+    CHECK_EQUAL(tfm::format("[%-14s]", sa4.sin_addr), "[192.0.2.255   ]");
+    CHECK_EQUAL(tfm::format("[%14s]", sa4.sin_addr), "[   192.0.2.255]");
+    CHECK_EQUAL(tfm::format("%.5s", sa4.sin_addr), "192.0");
+    const unsigned short v6a[8] = {0x2001, 0xdb8, 0, 0, 0, 0, 0, 1};
+    const unsigned short v6b[8] = {0x2001, 0xdb8, 0, 1, 0, 0, 0, 1};
+    const unsigned short v6c[8] = {0x2001, 0xdb8, 0, 0, 1, 0, 0, 1};
+    const unsigned short v6d[8] = {0x2001, 0xdb8, 0, 1, 1, 1, 1, 1};
+    const unsigned short v6e[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    const unsigned short v6f[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    const unsigned short v6g[8] = {0xfe80, 0, 0, 0, 0, 0, 0, 0};
+    const unsigned short v6h[8] = {0, 0, 0, 0, 0, 0xffff, 0xc000, 0x0280};
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6a, 0).sin6_addr), "2001:db8::1");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6b, 0).sin6_addr), "2001:db8:0:1::1");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6c, 0).sin6_addr), "2001:db8::1:0:0:1");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6d, 0).sin6_addr), "2001:db8:0:1:1:1:1:1");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6e, 0).sin6_addr), "::");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6f, 0).sin6_addr), "::1");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6g, 0).sin6_addr), "fe80::");
+    CHECK_EQUAL(tfm::format("%s", makeSockaddrIn6(v6h, 0).sin6_addr), "::ffff:192.0.2.128");
+    sockaddr_in6 sa6 = makeSockaddrIn6(v6a, 443);
+    CHECK_EQUAL(tfm::format("%s", sa6), "[2001:db8::1]:443");
+    sa6.sin6_scope_id = 3;
+    CHECK_EQUAL(tfm::format("%s", sa6), "[2001:db8::1%3]:443");
+#   endif
+
+    // Test padding of UTF-8 strings by display width
+#   ifdef TINYFORMAT_UTF8_DISPLAY_WIDTH
+    CHECK_EQUAL(tfm::format("[%-6s]", "\xe4\xb8\xad\xe6\x96\x87"), "[\xe4\xb8\xad\xe6\x96\x87  ]");
+    CHECK_EQUAL(tfm::format("[%6s]", std::string("caf\xc3\xa9")), "[  caf\xc3\xa9]");
+    CHECK_EQUAL(tfm::format("[%4s]", "e\xcc\x81"), "[   e\xcc\x81]"); // combining accent
+    CHECK_EQUAL(tfm::format("[%-12s]", "abcdefghij\xf0\x9f\x98\x80"), "[abcdefghij\xf0\x9f\x98\x80]");
+    CHECK_EQUAL(tfm::format("[%3s]", "\xff"), "[  \xff]"); // malformed byte
+    CHECK_EQUAL(tfm::format("[%10s]", "plain ascii"), "[plain ascii]");
+#   else
+    // By default the padding counts bytes
+    CHECK_EQUAL(tfm::format("[%6s]", std::string("caf\xc3\xa9")), "[ caf\xc3\xa9]");
+#   endif
+
+    // Test UTF-8 truncation at code point boundaries
+    const char* utf8Str = "a\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80"; // 1+2+3+4 bytes
+#   ifdef TINYFORMAT_UTF8_TRUNCATION
+    CHECK_EQUAL(tfm::format("%.1s", utf8Str), "a");
+    CHECK_EQUAL(tfm::format("%.2s", utf8Str), "a");
+    CHECK_EQUAL(tfm::format("%.3s", utf8Str), "a\xc3\xa9");
+    CHECK_EQUAL(tfm::format("%.5s", utf8Str), "a\xc3\xa9");
+    CHECK_EQUAL(tfm::format("%.6s", utf8Str), "a\xc3\xa9\xe4\xb8\xad");
+    CHECK_EQUAL(tfm::format("%.9s", std::string(utf8Str)), "a\xc3\xa9\xe4\xb8\xad");
+    CHECK_EQUAL(tfm::format("%.10s", std::string(utf8Str)), utf8Str);
+    CHECK_EQUAL(tfm::format("%.3s", "\x80\x80\x80\x80"), "\x80\x80\x80"); // malformed
+    const char noTerminator[4] = {'a', 'b', '\xc3', '\xa9'};
+    CHECK_EQUAL(tfm::format("%.3s", noTerminator), "ab");
+#   ifdef TINYFORMAT_HAS_STRING_VIEW
+    CHECK_EQUAL(tfm::format("%.8s", std::string_view(utf8Str)), "a\xc3\xa9\xe4\xb8\xad");
+#   ifdef TINYFORMAT_UTF8_DISPLAY_WIDTH
+    CHECK_EQUAL(tfm::format("[%-6.4s]", std::string_view(utf8Str)), "[a\xc3\xa9    ]");
+#   endif
+#   endif
+#   else
+    // By default truncation counts bytes, and may split a code point
+    CHECK_EQUAL(tfm::format("%.2s", utf8Str), "a\xc3");
+    CHECK_EQUAL(tfm::format("%.3s", std::string(utf8Str)), "a\xc3\xa9");
+#   endif
+
+    // Test structured key=value and JSON output
+    {
+        std::ostringstream kv;
+        tfm::formatKeyValue(kv, "msg=%s user=%s latency_ms=%d ratio=%.2f empty=%s",
+                            "login ok", "bob", 12, 0.5, "");
+        CHECK_EQUAL(kv.str(), "msg=\"login ok\" user=bob latency_ms=12 ratio=0.50 empty=\"\"");
+        kv.str("");
+        tfm::formatKeyValue(kv, "path=%s q=%s", "a\"b\\c", "x=1\ny");
+        CHECK_EQUAL(kv.str(), "path=\"a\\\"b\\\\c\" q=\"x=1\\ny\"");
+        std::ostringstream json;
+        tfm::formatJson(json, "request done user=%s latency_ms=%d ratio=%.2f ok=%s code=%d",
+                        "bob \"b\"", 12, -0.5, true, "n/a");
+        CHECK_EQUAL(json.str(), "{\"user\":\"bob \\\"b\\\"\",\"latency_ms\":12,"
+                                "\"ratio\":-0.50,\"ok\":\"true\",\"code\":\"n/a\"}");
+        json.str("");
+        tfm::formatJson(json, "%d took %05.1fs x=%*d", 7, 1.5, 3, 1);
+        CHECK_EQUAL(json.str(), "{\"arg0\":7,\"arg1\":\"001.5\",\"x\":\"  1\"}");
+        json.str("");
+        tfm::formatJson(json, "tab=%s", "\t\x01");
+        CHECK_EQUAL(json.str(), "{\"tab\":\"\\t\\u0001\"}");
+        EXPECT_ERROR( tfm::formatJson(json, "a=%d b=%d", 1) )
+        EXPECT_ERROR( tfm::formatKeyValue(json, "a=%d", 1, 2) )
+        // Values longer than the internal buffer
+        std::string longValue = std::string(150, 'x') + "\"";
+        json.str("");
+        tfm::formatJson(json, "long=%s n=%d", longValue, 1);
+        CHECK_EQUAL(json.str(), "{\"long\":\"" + std::string(150, 'x') + "\\\"\",\"n\":1}");
+        kv.str("");
+        tfm::formatKeyValue(kv, "long=%-152s n=%d", longValue, 1);
+        CHECK_EQUAL(kv.str(), "long=\"" + std::string(150, 'x') + "\\\" \" n=1");
+    }
+
+    // Test binary conversions
+    CHECK_EQUAL(tfm::format("%b %b %b", 5, 0, 255u), "101 0 11111111");
+    CHECK_EQUAL(tfm::format("%#b %#B %#b", 5, 5, 0), "0b101 0B101 0");
+    CHECK_EQUAL(tfm::format("[%8b|%-8b|%08b|%#010b]", 5, 5, 5, 5),
+                "[     101|101     |00000101|0b00000101]");
+    CHECK_EQUAL(tfm::format("%.6b %.2b", 5, 5), "000101 101");
+    CHECK_EQUAL(tfm::format("%b", -1), std::string(8*sizeof(int), '1'));
+    CHECK_EQUAL(tfm::format("%b %b", (short)-2, (unsigned char)6), "1111111111111110 110");
+    CHECK_EQUAL(tfm::format("%b %B", (signed char)-1, (signed char)-128), "11111111 10000000");
+    CHECK_EQUAL(tfm::format("%b", 0x8000000000000001ULL), "1" + std::string(62, '0') + "1");
+    CHECK_EQUAL(tfm::format("%b %b %s", true, 'A', 0x100), "1 1000001 256");
+    CHECK_EQUAL(tfm::format("%b|%5b", 1.5, "ab"), "1.5|   ab");
+    CHECK_EQUAL(tfm::formatBraces("{:#b} {:08b}", 6, 6), "0b110 00000110");
+
+    // Test UUID and hex identifier formatting
+    const unsigned char uuidBytes[16] = {0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3,
+                                         0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00};
+    CHECK_EQUAL(tfm::format("%s", tfm::uuid(uuidBytes)), "123e4567-e89b-12d3-a456-426614174000");
+    CHECK_EQUAL(tfm::format("%X", tfm::uuid(uuidBytes)), "123E4567-E89B-12D3-A456-426614174000");
+    CHECK_EQUAL(tfm::format("%.8s", tfm::uuid(uuidBytes)), "123e4567");
+    CHECK_EQUAL(tfm::format("%s", tfm::hexId(0xbeefULL)), "000000000000beef");
+    CHECK_EQUAL(tfm::format("%X", tfm::hexId(0x0123456789abcdefULL)), "0123456789ABCDEF");
+    CHECK_EQUAL(tfm::format("%s", tfm::hexId(0x4bf92f3577b34da6ULL, 0xa3ce929d0e0e4736ULL)),
+                "4bf92f3577b34da6a3ce929d0e0e4736");
+    CHECK_EQUAL(tfm::format("[%-18s]", tfm::hexId(1)), "[0000000000000001  ]");
+
+#ifndef TINYFORMAT_NO_HEAP
+    // Test syslog record formatting
+    {
+        tfm::SyslogWriter syslog(tfm::SyslogWriter::Local0, "host1", "my app", 1234);
+        syslog.vformatRecord(tfm::SyslogWriter::Warning, 1700000000LL, 5,
+                             "peer %s timed out", tfm::makeFormatList("x"));
+        CHECK_EQUAL(std::string(syslog.data(), syslog.size()),
+                    "<132>1 2023-11-14T22:13:20.000005Z host1 my_app 1234 - - peer x timed out");
+        syslog.vformatRecord(tfm::SyslogWriter::Debug, 951782400LL, 999999,
+                             "%d", tfm::makeFormatList(2));
+        CHECK_EQUAL(std::string(syslog.data(), syslog.size()),
+                    "<135>1 2000-02-29T00:00:00.999999Z host1 my_app 1234 - - 2");
+        // Microseconds out of range are carried into the seconds
+        syslog.vformatRecord(tfm::SyslogWriter::Debug, 951782400LL, 2500000,
+                             "%d", tfm::makeFormatList(3));
+        CHECK_EQUAL(std::string(syslog.data(), syslog.size()),
+                    "<135>1 2000-02-29T00:00:02.500000Z host1 my_app 1234 - - 3");
+        syslog.vformatRecord(tfm::SyslogWriter::Debug, 951782400LL, -1,
+                             "%d", tfm::makeFormatList(4));
+        CHECK_EQUAL(std::string(syslog.data(), syslog.size()),
+                    "<135>1 2000-02-28T23:59:59.999999Z host1 my_app 1234 - - 4");
+        // A record which leaves the stream in a failed state doesn't affect
+        // the next one
+        FailingValue failing;
+        syslog.vformatRecord(tfm::SyslogWriter::Debug, 951782400LL, 0,
+                             "%s", tfm::makeFormatList(failing));
+        syslog.vformatRecord(tfm::SyslogWriter::Debug, 951782400LL, 0,
+                             "after %d", tfm::makeFormatList(5));
+        CHECK_EQUAL(std::string(syslog.data(), syslog.size()),
+                    "<135>1 2000-02-29T00:00:00.000000Z host1 my_app 1234 - - after 5");
+#       ifdef TINYFORMAT_SINKS_POSIX
+        // Send a record through a local Unix datagram socket
+        std::string path = tfm::format("/tmp/tinyformat_test_syslog_%d", getpid());
+        int server = socket(AF_UNIX, SOCK_DGRAM, 0);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, path.c_str());
+        unlink(path.c_str());
+        CHECK_EQUAL(bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        CHECK_EQUAL(syslog.connect(path.c_str()), true);
+        CHECK_EQUAL(syslog.log(tfm::SyslogWriter::Error, "disk %s is %d%% full", "/var", 93), true);
+        char received[256];
+        ssize_t n = recv(server, received, sizeof(received), 0);
+        std::string record = n > 0 ? std::string(received, n) : std::string();
+        CHECK_EQUAL(record.substr(0, 7), "<131>1 ");
+        std::string suffix = " host1 my_app 1234 - - disk /var is 93% full";
+        CHECK_EQUAL(record.size(), 7 + 27 + suffix.size());
+        CHECK_EQUAL(record.substr(7 + 27), suffix);
+        close(server);
+        unlink(path.c_str());
+#       endif
+    }
+
+    // Test Prometheus metrics output
+    {
+        tfm::MetricSeries requests("http_requests_total");
+        requests.label("method", "GET").label("code", 200);
+        tfm::MetricSeries odd("odd");
+        odd.label("path", "C:\\dir \"x\"\n");
+        tfm::MetricsWriter metrics;
+        metrics.help("http_requests_total", "Total requests\\sec\n");
+        metrics.type("http_requests_total", "counter");
+        metrics.sample(requests, 1027);
+        metrics.sample(requests, 0.1, 1395066363000LL);
+        metrics.sample(tfm::MetricSeries("up"), 1.0 / 3.0);
+        metrics.sample(odd, -1e300 * 1e300);
+        metrics.sample(odd, 1.5e-7);
+        CHECK_EQUAL(metrics.str(),
+            "# HELP http_requests_total Total requests\\\\sec\\n\n"
+            "# TYPE http_requests_total counter\n"
+            "http_requests_total{method=\"GET\",code=\"200\"} 1027\n"
+            "http_requests_total{method=\"GET\",code=\"200\"} 0.1 1395066363000\n"
+            "up 0.3333333333333333\n"
+            "odd{path=\"C:\\\\dir \\\"x\\\"\\n\"} -Inf\n"
+            "odd{path=\"C:\\\\dir \\\"x\\\"\\n\"} 1.5e-07\n");
+        metrics.clear();
+        CHECK_EQUAL(metrics.size(), 0u);
+        // A global locale with a comma decimal point doesn't apply
+        std::locale::global(std::locale(std::locale::classic(), new CommaDecimalPoint));
+        tfm::MetricsWriter commaMetrics;
+        commaMetrics.sample(tfm::MetricSeries("a"), 0.1 + 0.2);
+        commaMetrics.sample(tfm::MetricSeries("b"), 2.5);
+        std::locale::global(std::locale::classic());
+        CHECK_EQUAL(commaMetrics.str(), "a 0.30000000000000004\nb 2.5\n");
+    }
+
+    // Test CSV and TSV output
+    {
+        std::ostringstream csvOut;
+        {
+            tfm::CsvWriter csv(csvOut);
+            csv.row("id", "name", "score");
+            csv.field(1).field("plain text, with comma").field("%.2f", 0.5).endRow();
+            csv.field(2).field(std::string("say \"hi\"")).field("line\nbreak").endRow();
+            csv.row(3, "", "a long field with no special characters at all");
+            CHECK_EQUAL(csvOut.str(), ""); // still buffered
+        }
+        CHECK_EQUAL(csvOut.str(),
+            "id,name,score\r\n"
+            "1,\"plain text, with comma\",0.50\r\n"
+            "2,\"say \"\"hi\"\"\",\"line\nbreak\"\r\n"
+            "3,,a long field with no special characters at all\r\n");
+        csvOut.str("");
+        {
+            tfm::CsvWriter unixCsv(csvOut, ';', 65536, "\n");
+            unixCsv.row(1, "a;b");
+        }
+        CHECK_EQUAL(csvOut.str(), "1;\"a;b\"\n");
+        std::ostringstream tsvOut;
+        tfm::CsvWriter tsv(tsvOut, '\t', 1);
+        tsv.row("a\tb", "c\\d", "e,\"f\"");
+        CHECK_EQUAL(tsvOut.str(), "a\\tb\tc\\\\d\te,\"f\"\n");
+        // Batches of rows from containers
+        std::vector<std::vector<std::string> > table(2);
+        table[0].push_back("x");
+        table[0].push_back("\"q\"\n");
+        table[1].push_back("");
+        csvOut.str("");
+        {
+            tfm::CsvWriter batch(csvOut);
+            batch.rows(table);
+            std::vector<int> nums(3, 7);
+            std::vector<std::vector<int> > numRows(2, nums);
+            batch.rows(numRows.begin(), numRows.end());
+        }
+        CHECK_EQUAL(csvOut.str(), "x,\"\"\"q\"\"\n\"\r\n\r\n7,7,7\r\n7,7,7\r\n");
+        tsvOut.str("");
+        tsv.rows(table);
+        CHECK_EQUAL(tsvOut.str(), "x\t\"q\"\\n\n\n");
+        // Quoted fields which grow beyond the fixed part of the buffer
+        std::string quotes(3000, '"');
+        csvOut.str("");
+        {
+            tfm::CsvWriter big(csvOut);
+            big.row(quotes, quotes);
+        }
+        std::string quoted = "\"" + std::string(6000, '"') + "\"";
+        CHECK_EQUAL(csvOut.str(), quoted + "," + quoted + "\r\n");
+    }
+
+    // Test formatting once for multiple destinations
+    {
+        std::ostringstream all, errors;
+        tfm::TeeWriter tee;
+        tee.addStream(all, 7);
+        tee.addStream(errors, 3);
+        tee.log(6, "connected to %s:%d", "db", 5432);
+        tee.log(3, "query failed: %s", "timeout");
+        CHECK_EQUAL(all.str(), "connected to db:5432\nquery failed: timeout\n");
+        CHECK_EQUAL(errors.str(), "query failed: timeout\n");
+        CHECK_EQUAL(tee.enabled(7), true);
+        CHECK_EQUAL(tee.enabled(8), false);
+        // Arguments aren't formatted when no destination wants the message
+        MyCountingInt counter;
+        tee.log(8, "%s", counter);
+        CHECK_EQUAL(counter.timesFormatted(), 0);
+        tee.log(2, "%s", counter);
+        CHECK_EQUAL(counter.timesFormatted(), 1);
+    }
+#endif // TINYFORMAT_NO_HEAP
+
+    // Test formatting into a fixed size buffer
+    {
+        char buf[8];
+        CHECK_EQUAL(tfm::formatToBuffer(buf, sizeof(buf), "%d-%s", 42, "ab"), 5u);
+        CHECK_EQUAL(std::string(buf), "42-ab");
+        CHECK_EQUAL(tfm::formatToBuffer(buf, sizeof(buf), "%s|%5d", "abcd", 1), 10u);
+        CHECK_EQUAL(std::string(buf), "abcd|  ");
+        CHECK_EQUAL(tfm::formatToBuffer(buf, 0, "%d", 123), 3u);
+        CHECK_EQUAL(tfm::formatToBuffer(buf, 1, "%d", 123), 3u);
+        CHECK_EQUAL(std::string(buf), "");
+    }
+
+#ifndef TINYFORMAT_NO_HEAP
+    // Test duplicate message suppression
+    {
+        std::ostringstream out;
+        {
+            tfm::DuplicateFilter filter(out, 1e9);
+            const char* fmt = "error %d on %s";
+            std::string dev = "sda";
+            for(int i = 0; i < 5; ++i)
+            {
+                CHECK_EQUAL(filter.log(fmt, 5, dev), i == 0);
+                filter.log("other %s", "message");
+            }
+            CHECK_EQUAL(filter.log(fmt, 6, dev), true);
+            // Other types are identified by their formatted text
+            CHECK_EQUAL(filter.log("id %s", tfm::hexId(1)), true);
+            CHECK_EQUAL(filter.log("id %s", tfm::hexId(1)), false);
+            CHECK_EQUAL(filter.log("id %s", tfm::hexId(2)), true);
+            unsigned char buf[] = "aaa";
+            CHECK_EQUAL(filter.log("dup: %s", buf + 0), true);
+            buf[0] = 'b';
+            CHECK_EQUAL(filter.log("dup: %s", buf + 0), true);
+        }
+        CHECK_EQUAL(out.str(), "error 5 on sda\nother message\nerror 6 on sda\n"
+                    "id 0000000000000001\nid 0000000000000002\n"
+                    "dup: aaa\ndup: baa\n"
+                    "message repeated 4 times: error 5 on sda\n"
+                    "message repeated 4 times: other message\n"
+                    "message repeated 1 times: id 0000000000000001\n");
+        out.str("");
+        tfm::DuplicateFilter noWindow(out, 0);
+        noWindow.log("x");
+        CHECK_EQUAL(noWindow.log("x"), true);
+        CHECK_EQUAL(out.str(), "x\nx\n");
+    }
+#endif // TINYFORMAT_NO_HEAP
+
+    // Test non-materialising output sinks
+    {
+        std::string key = tfm::format("%s:%d/%.3f", "host", 8080, 1.5);
+        CHECK_EQUAL(tfm::formatHash("%s:%d/%.3f", "host", 8080, 1.5),
+                    tfm::detail::fnv1a(tfm::detail::fnvOffsetBasis, key.data(), key.size()));
+        CHECK_EQUAL(tfm::formatHash(""), tfm::detail::fnvOffsetBasis);
+        std::string longStr(1000, 'z');
+        CHECK_EQUAL(tfm::formatHash("%s%d", longStr, 1),
+                    tfm::detail::fnv1a(tfm::detail::fnvOffsetBasis,
+                                       (longStr + "1").data(), 1001));
+        CHECK_EQUAL(tfm::formattedLength("%s:%d/%.3f", "host", 8080, 1.5), key.size());
+        CHECK_EQUAL(tfm::formattedLength("%s %s", longStr, longStr), 2001u);
+        CHECK_EQUAL(tfm::formatEquals(key, "%s:%d/%.3f", "host", 8080, 1.5), true);
+        CHECK_EQUAL(tfm::formatEquals("host:8080", "%s:%d", "host", 8080), true);
+        CHECK_EQUAL(tfm::formatEquals("host:8080", "%s:%d", "host", 8081), false);
+        CHECK_EQUAL(tfm::formatEquals("host:80", "%s:%d", "host", 8080), false);
+        CHECK_EQUAL(tfm::formatEquals("host:8080x", "%s:%d", "host", 8080), false);
+        CHECK_EQUAL(tfm::formatEquals("", ""), true);
+    }
+
+    // Test length-prefixed frames
+    {
+        tfm::FrameWriter be16(tfm::FrameWriter::BigEndian16);
+        be16.frame("PUT %s %d", "key", 42);
+        be16.frame("");
+        CHECK_EQUAL(std::string(be16.data(), be16.size()),
+                    std::string("\0\x0aPUT key 42\0\0", 14));
+        tfm::FrameWriter le32(tfm::FrameWriter::LittleEndian32);
+        le32.frame("%s", std::string(300, 'x'));
+        CHECK_EQUAL(std::string(le32.data(), 4), std::string("\x2c\x01\0\0", 4));
+        CHECK_EQUAL(le32.size(), 304u);
+        le32.clear();
+        CHECK_EQUAL(le32.size(), 0u);
+        tfm::FrameWriter be32(tfm::FrameWriter::BigEndian32);
+        be32.frame("%d", 7);
+        CHECK_EQUAL(std::string(be32.data(), be32.size()), std::string("\0\0\0\x01" "7", 5));
+        tfm::FrameWriter varint(tfm::FrameWriter::Varint32);
+        varint.frame("%s", std::string(300, 'y'));
+        CHECK_EQUAL(std::string(varint.data(), 5), std::string("\xac\x82\x80\x80\0", 5));
+        // Dropped frames leave the buffer as it was
+#       ifdef TINYFORMAT_NO_HEAP
+        CHECK_EQUAL(be16.frame("%s", std::string(2000, 'z')), false);
+#       else
+        EXPECT_ERROR( be16.frame("%s", std::string(70000, 'z')) )
+#       endif
+        EXPECT_ERROR( be16.frame("%d %d", 1) )
+        CHECK_EQUAL(be16.size(), 14u);
+        CHECK_EQUAL(be16.frame("%d", 1), true);
+        CHECK_EQUAL(std::string(be16.data() + 14, be16.size() - 14),
+                    std::string("\0\x01" "1", 3));
+    }
+
+#ifdef TINYFORMAT_SINKS_POSIX
+    // Test async-signal-safe formatting
+    {
+        int fds[2];
+        CHECK_EQUAL(pipe(fds), 0);
+        char buf[256];
+        int n = tfm::signal_safe::dprintf(fds[1],
+                    "%d|%5u|%-4x|%#X|%#o|%c|%s|%-5.2s|%08d|%+i|%.3d|%ld|%x|%hd|%%",
+                    -42, 7u, 255, 255UL, 8, 'z', "str", "abc", -123, 5, 7,
+                    -9000000000LL, -1, (short)-3);
+        CHECK_EQUAL(std::string(buf, read(fds[0], buf, sizeof(buf))),
+                    "-42|    7|ff  |0XFF|010|z|str|ab   |-0000123|+5|007|-9000000000|ffffffff|-3|%");
+        CHECK_EQUAL(n, 77);
+        int* ptr = reinterpret_cast<int*>(0x1234);
+        std::string longStr(300, 'x');
+        tfm::signal_safe::dprintf(fds[1], "%p %10p %d %s %f %d", ptr, (void*)0, -1, "a");
+        CHECK_EQUAL(std::string(buf, read(fds[0], buf, sizeof(buf))),
+                    "0x1234        0x0 -1 a %!f %!d(missing)");
+        // Unsupported conversions consume their argument
+        tfm::signal_safe::dprintf(fds[1], "%c|%a|%-5n|%d|%5", "str", 1, 2, 3);
+        CHECK_EQUAL(std::string(buf, read(fds[0], buf, sizeof(buf))), "%!c|%!a|%!n|3|%!");
+        CHECK_EQUAL(tfm::signal_safe::dprintf(fds[1], "%s", longStr.c_str()), 300);
+        CHECK_EQUAL(std::string(buf, read(fds[0], buf, sizeof(buf))), longStr.substr(0, 256));
+        CHECK_EQUAL(std::string(buf, read(fds[0], buf, sizeof(buf))), longStr.substr(0, 44));
+        close(fds[0]);
+        close(fds[1]);
+        // errno is preserved, even when writing fails
+        errno = EAGAIN;
+        CHECK_EQUAL(tfm::signal_safe::dprintf(-1, "bad fd"), -1);
+        CHECK_EQUAL(errno, EAGAIN);
+#       ifdef TINYFORMAT_SINKS_CXX11
+        // Literal format strings may be checked at compile time
+        CHECK_EQUAL(pipe(fds), 0);
+        TINYFORMAT_SIGNAL_SAFE_DPRINTF(fds[1], "%d|%-3c|%s|%5s|%p|%%|%lu",
+                                       -1, 'x', "str", 'c', ptr, 2UL);
+        TINYFORMAT_SIGNAL_SAFE_DPRINTF(fds[1], "|none");
+        CHECK_EQUAL(std::string(buf, read(fds[0], buf, sizeof(buf))),
+                    "-1|x  |str|    c|0x1234|%|2|none");
+        close(fds[0]);
+        close(fds[1]);
+        using tfm::signal_safe::detail::checkFormat;
+        static_assert(checkFormat("%+08.3lld %#x %c %s %p %s", "iicsps"), "");
+        static_assert(checkFormat("%%", ""), "");
+        static_assert(!checkFormat("%f", "i"), "unsupported conversion");
+        static_assert(!checkFormat("%c", "s"), "%c with a string");
+        static_assert(!checkFormat("%d", "s"), "%d with a string");
+        static_assert(!checkFormat("%p", "i"), "%p with an integer");
+        static_assert(!checkFormat("%d %d", "i"), "missing argument");
+        static_assert(!checkFormat("%d", "ii"), "extra argument");
+        static_assert(!checkFormat("%5", "i"), "incomplete spec");
+#       endif
+#       ifdef TEST_SIGNAL_SAFE_FORMAT_COMPILE
+        // Unsupported conversion - should fail to compile!
+        TINYFORMAT_SIGNAL_SAFE_DPRINTF(2, "%f", 1);
+#       endif
+    }
+#endif
+
+#ifdef TINYFORMAT_SINKS_SHM_RING
+    // Test shared memory log ring
+    {
+        std::string name = tfm::format("/tinyformat_test_%d", getpid());
+        tfm::ShmLogRing consumer;
+        CHECK_EQUAL(consumer.create(name.c_str(), 200), true);
+        tfm::ShmLogRing producer;
+        CHECK_EQUAL(producer.open(name.c_str()), true);
+        std::string s = "str";
+        producer.log("%d %u %s %s %.2f %c %x %5s|%-3d|", -1, 2u, "lit", s, 1.5, 'x',
+                     255ULL, (const char*)"cs", (short)7);
+        producer.log("id %s", tfm::hexId(0xab));
+        std::ostringstream out;
+        CHECK_EQUAL(consumer.drain(out), 2u);
+        CHECK_EQUAL(out.str(), "-1 2 lit str 1.50 x ff    cs|7  |\nid 00000000000000ab\n");
+        // Wrap around the end of the buffer many times
+        std::string expected;
+        out.str("");
+        for(int i = 0; i < 40; ++i)
+        {
+            producer.log("message %d", i);
+            consumer.read(out);
+            expected += tfm::format("message %d", i);
+        }
+        CHECK_EQUAL(out.str(), expected);
+        // Messages are dropped when the ring is full
+        for(int i = 0; i < 10; ++i)
+            producer.write("0123456789", 10);
+        CHECK_EQUAL(producer.dropped(), 4u);
+        out.str("");
+        CHECK_EQUAL(consumer.drain(out), 6u);
+        // Deferred records give the same output as direct formatting for
+        // pointers which aren't formatted as addresses
+        unsigned char uhello[] = "hello";
+        Node root = { "root" };
+        const void* vp = &root;
+        producer.log("%s %s %s %p", uhello + 0, (const signed char*)"sc", &root, vp);
+        out.str("");
+        consumer.drain(out);
+        CHECK_EQUAL(out.str(), tfm::format("%s %s %s %p\n", uhello + 0,
+                                           (const signed char*)"sc", &root, vp));
+        // Several threads logging while the ring is drained.  The ring has
+        // room for every message, so none may be dropped, torn or reordered
+        // within a thread.
+        CHECK_EQUAL(consumer.create(name.c_str(), 1 << 20), true);
+        CHECK_EQUAL(producer.open(name.c_str()), true);
+        const int nthreads = 4;
+        const int nmessages = 2000;
+        std::vector<std::thread> threads;
+        std::atomic<bool> start(false);
+        std::atomic<int> finished(0);
+        for(int t = 0; t < nthreads; ++t)
+        {
+            threads.push_back(std::thread([t, nmessages, &start, &finished, &producer]() {
+                while(!start.load())
+                    std::this_thread::yield();
+                for(int m = 0; m < nmessages; ++m)
+                {
+                    // Mix deferred and preformatted records
+                    if(m % 3 == 0)
+                    {
+                        std::string text = tfm::format("thread %d msg %d check %d",
+                                                       t, m, 1000*t + m);
+                        producer.write(text.data(), text.size());
+                    }
+                    else
+                        producer.log("thread %d msg %d check %d", t, m, 1000*t + m);
+                }
+                ++finished;
+            }));
+        }
+        start.store(true);
+        out.str("");
+        while(finished.load() < nthreads)
+            consumer.drain(out);
+        for(int t = 0; t < nthreads; ++t)
+            threads[t].join();
+        consumer.drain(out);
+        CHECK_EQUAL(producer.dropped(), 0u);
+        std::vector<int> nextMsg(nthreads, 0);
+        int badLines = 0;
+        std::istringstream ringLines(out.str());
+        std::string line;
+        while(std::getline(ringLines, line))
+        {
+            int t = -1, m = -1, check = -1;
+            std::sscanf(line.c_str(), "thread %d msg %d check %d", &t, &m, &check);
+            if(t < 0 || t >= nthreads || check != 1000*t + m || m != nextMsg[t]++)
+                ++badLines;
+        }
+        CHECK_EQUAL(badLines, 0);
+        for(int t = 0; t < nthreads; ++t)
+            CHECK_EQUAL(nextMsg[t], nmessages);
+        CHECK_EQUAL(tfm::ShmLogRing::unlink(name.c_str()), true);
+        CHECK_EQUAL(producer.open(name.c_str()), false);
+    }
+#endif
+
+#ifdef TINYFORMAT_SINKS_CXX11
+    // Test flight recorder
+    {
+        tfm::FlightRecorder::clear();
+        std::string s = "str";
+        tfm::FlightRecorder::record("first %d %s %.2f", 1, s, 0.5);
+        tfm::FlightRecorder::record("second %s", tfm::hexId(0xab));
+        tfm::FlightRecorder::record("third %s|", std::string(200, 'x'));
+        std::ostringstream out;
+        tfm::FlightRecorder::dump(out);
+        std::istringstream lines(out.str());
+        std::string line;
+        std::getline(lines, line);
+        // Lines start with a UTC timestamp, like 2024-01-02T03:04:05.123456
+        CHECK_EQUAL(line.size() > 27 && line[10] == 'T' && line[19] == '.', true);
+        CHECK_EQUAL(line.substr(27), "[0] first 1 str 0.50");
+        std::getline(lines, line);
+        CHECK_EQUAL(line.substr(27), "[0] second 00000000000000ab");
+        std::getline(lines, line);
+        CHECK_EQUAL(line.substr(27), "[0] third " + std::string(90, 'x') + "|");
+        // Only the most recent messages are kept
+        for(int i = 0; i < tfm::FlightRecorder::recordsPerThread + 10; ++i)
+            tfm::FlightRecorder::record("message %d", i);
+        out.str("");
+        tfm::FlightRecorder::dump(out);
+        std::string dumped = out.str();
+        CHECK_EQUAL(dumped.substr(27, 15), "[0] message 10\n");
+        CHECK_EQUAL(std::count(dumped.begin(), dumped.end(), '\n'),
+                    tfm::FlightRecorder::recordsPerThread);
+        tfm::FlightRecorder::clear();
+        // Char arrays needn't be null terminated
+        const char unterminated[4] = { 'a', 'b', 'c', 'd' };
+        tfm::FlightRecorder::record("%.3s|", unterminated);
+        out.str("");
+        tfm::FlightRecorder::dump(out);
+        CHECK_EQUAL(out.str().substr(27), "[0] abc|\n");
+        tfm::FlightRecorder::clear();
+        // Pointers are recorded as their formatted text unless they're void*
+        unsigned char uhello[] = "hello";
+        Node root = { "root" };
+        const void* vp = &root;
+        tfm::FlightRecorder::record("%s %s %p", uhello + 0, &root, vp);
+        out.str("");
+        tfm::FlightRecorder::dump(out);
+        CHECK_EQUAL(out.str().substr(27), "[0] " + tfm::format("%s %s %p", uhello + 0, &root, vp) + "\n");
+        tfm::FlightRecorder::clear();
+        // Several threads recording while the rings are dumped
+        const int nthreads = 4;
+        const int nmessages = 3*tfm::FlightRecorder::recordsPerThread;
+        std::vector<std::thread> threads;
+        std::atomic<bool> start(false);
+        for(int t = 0; t < nthreads; ++t)
+        {
+            threads.push_back(std::thread([t, nmessages, &start]() {
+                while(!start.load())
+                    std::this_thread::yield();
+                for(int m = 0; m < nmessages; ++m)
+                    tfm::FlightRecorder::record("thread %d msg %d check %d", t, m, 1000*t + m);
+            }));
+        }
+        start.store(true);
+        int tornLines = 0;
+        for(int i = 0; i < 20; ++i)
+        {
+            out.str("");
+            tfm::FlightRecorder::dump(out);
+            std::istringstream dumpLines(out.str());
+            while(std::getline(dumpLines, line))
+            {
+                int t = -1, m = -1, check = -1;
+                std::sscanf(line.c_str() + line.find("] ") + 2,
+                            "thread %d msg %d check %d", &t, &m, &check);
+                if(check != 1000*t + m)
+                    ++tornLines;
+            }
+        }
+        for(int t = 0; t < nthreads; ++t)
+            threads[t].join();
+        CHECK_EQUAL(tornLines, 0);
+        // Each thread's most recent messages are kept
+        out.str("");
+        tfm::FlightRecorder::dump(out);
+        dumped = out.str();
+        CHECK_EQUAL(std::count(dumped.begin(), dumped.end(), '\n'),
+                    nthreads*tfm::FlightRecorder::recordsPerThread);
+        for(int t = 0; t < nthreads; ++t)
+        {
+            for(int m = nmessages - tfm::FlightRecorder::recordsPerThread; m < nmessages; ++m)
+            {
+                std::string msg = tfm::format("] thread %d msg %d check %d\n", t, m, 1000*t + m);
+                CHECK_EQUAL(dumped.find(msg) != std::string::npos, true);
+            }
+        }
+        tfm::FlightRecorder::clear();
+    }
+#endif
+
+    // Test joined ranges
+    {
+        std::vector<int> v;
+        v.push_back(1); v.push_back(-2); v.push_back(30);
+        CHECK_EQUAL(tfm::format("[%s]", tfm::join(v, ", ")), "[1, -2, 30]");
+        CHECK_EQUAL(tfm::format("%s|%d", tfm::join(v, " ", "%+04d"), 5), "+001 -002 +030|5");
+        CHECK_EQUAL(tfm::format("%s", tfm::join(v.begin(), v.begin() + 2, ":", "%x")), "1:fffffffe");
+        const char* names[] = {"ab", "c"};
+        CHECK_EQUAL(tfm::format("%s", tfm::join(names, ",", "%-3s")), "ab ,c  ");
+        double d[] = {1, 2.5};
+        CHECK_EQUAL(tfm::format("%s", tfm::join(d, "; ", "%.2f")), "1.00; 2.50");
+        CHECK_EQUAL(tfm::format("[%s]", tfm::join(std::vector<int>(), ",")), "[]");
+        // The outer width and precision apply to the whole result
+        CHECK_EQUAL(tfm::format("[%12s|%-12s]", tfm::join(v, ","), tfm::join(v, ",")),
+                    "[     1,-2,30|1,-2,30     ]");
+        CHECK_EQUAL(tfm::format("[%.4s|%6.3s]", tfm::join(v, ","), tfm::join(v, ", ", "%+d")),
+                    "[1,-2|   +1,]");
+        std::ostringstream out;
+        out << tfm::join(v, "-") << ' ' << 3.5;
+        CHECK_EQUAL(out.str(), "1--2-30 3.5");
+        EXPECT_ERROR( tfm::format("%s", tfm::join(v, ",", "%d%d")) )
+        EXPECT_ERROR( tfm::format("%s", tfm::join(v, ",", "d")) )
+    }
+
+    // Test 16 bit floating point values
+    {
+        CHECK_EQUAL(tfm::format("%s %s %s %s", tfm::half(0x3c00), tfm::half(0xc000),
+                                tfm::half(0x7bff), tfm::half(0x3555)), "1 -2 65504 0.333252");
+        CHECK_EQUAL(tfm::format("%g %g %s", tfm::half(0x0001), tfm::half(0x03ff),
+                                tfm::half(0x8000)), "5.96046e-08 6.09756e-05 -0");
+        CHECK_EQUAL(tfm::format("%s %s", tfm::half(0x7c00), tfm::half(0xfc00)), "inf -inf");
+        CHECK_EQUAL(tfm::format("%.5f %s", tfm::bfloat16(0x4049), tfm::bfloat16(0xbf80)), "3.14062 -1");
+        CHECK_EQUAL(tfm::format("%8.2f|", tfm::half(0x4248)), "    3.14|");
+        unsigned short halves[200];
+        std::string expected;
+        for(int i = 0; i < 200; ++i)
+        {
+            // Half precision bits of the integer i: the leading one is
+            // implicit and the remaining bits form the top of the mantissa.
+            int e = 0;
+            while((i >> (e + 1)) != 0)
+                ++e;
+            halves[i] = static_cast<unsigned short>(i == 0 ? 0 :
+                            ((15 + e) << 10) | ((i << (10 - e)) & 0x3ff));
+            expected += tfm::format(i == 0 ? "%d" : ",%d", i);
+        }
+        CHECK_EQUAL(tfm::format("%s", tfm::halfArray(halves, 200, ",", "%.4g")), expected);
+        CHECK_EQUAL(tfm::format("[%s]", tfm::halfArray(halves + 2, 3, " ", "%5.2f")),
+                    "[ 2.00  3.00  4.00]");
+        // The outer width and precision apply to the whole result
+        CHECK_EQUAL(tfm::format("[%8s|%-6.4s]", tfm::halfArray(halves, 3, ","),
+                                tfm::halfArray(halves + 8, 3, ",")), "[   0,1,2|8,9,  ]");
+        unsigned short bf[] = { 0x3f80, 0x4000, 0xc040 };
+        std::ostringstream out;
+        out << tfm::bfloat16Array(bf, 3, ", ") << ';' << tfm::halfArray(bf, 0, ",");
+        CHECK_EQUAL(out.str(), "1, 2, -3;");
+    }
+
+    // Test concatenation without a format string
+    {
+        std::string host = "example.com";
+        CHECK_EQUAL(tfm::cat(host, ':', 8080), "example.com:8080");
+        CHECK_EQUAL(tfm::cat(1.5, " ", true, " ", (void*)0 == 0), "1.5 true true");
+        CHECK_EQUAL(tfm::cat(), "");
+        CHECK_EQUAL(tfm::cat(std::string(300, 'a'), 1).size(), 301u);
+        std::ostringstream out;
+        out << std::hex;
+        out.width(4);
+        tfm::catTo(out, 255, "|", 'c');
+        out << 255;
+        CHECK_EQUAL(out.str(), "255|c  ff");
+    }
+
+    // Test lazy formatting proxy
+    {
+        std::ostringstream out;
+        out << "[" << tfm::lazy("%d-%s", 42, "x") << "]" << tfm::lazy("none");
+        CHECK_EQUAL(out.str(), "[42-x]none");
+#       ifndef TINYFORMAT_NO_HEAP
+        std::string str = tfm::lazy("%.2f", 1.5);
+        CHECK_EQUAL(str, "1.50");
+        CHECK_EQUAL(tfm::lazy("%5s", "ab").str(), "   ab");
+#       endif
+        CHECK_EQUAL(tfm::format("<%s>", tfm::lazy("%03d", 7)), "<007>");
+    }
+
+    // Test brace style format strings
+    {
+        CHECK_EQUAL(tfm::formatBraces("{} + {} = {}", 1, 2.5, "3.5"), "1 + 2.5 = 3.5");
+        CHECK_EQUAL(tfm::formatBraces("{1}-{0}-{1}", "a", 7), "7-a-7");
+        CHECK_EQUAL(tfm::formatBraces("[{:>8.3f}]", 3.14159), "[   3.142]");
+        CHECK_EQUAL(tfm::formatBraces("[{:<6}|{:6}|{:6}]", 42, 42, "ab"), "[42    |    42|ab    ]");
+        CHECK_EQUAL(tfm::formatBraces("[{:*^7}|{:^6}]", "ab", 1), "[**ab***|  1   ]");
+        CHECK_EQUAL(tfm::formatBraces("{:#x} {:08X} {:+d} {: d}", 255, 255, 5, 5), "0xff 000000FF +5  5");
+        CHECK_EQUAL(tfm::formatBraces("{:.2s}|{:e}|{}", "abcdef", 1.5, true), "ab|1.500000e+00|true");
+        CHECK_EQUAL(tfm::formatBraces("{{{}}} }}", 1), "{1} }");
+        CHECK_EQUAL(tfm::formatBraces("{:_>5}", -12), "__-12");
+        CHECK_EQUAL(tfm::formatBraces("no fields"), "no fields");
+        // All string types are left aligned by default
+        std::string str = "ab";
+        unsigned char ustr[] = "ab";
+        char arr[] = "ab";
+        CHECK_EQUAL(tfm::formatBraces("[{:4}|{:4}|{:4}|{:>4}]", str, ustr + 0, arr, str),
+                    "[ab  |ab  |ab  |  ab]");
+#       ifdef TINYFORMAT_HAS_STRING_VIEW
+        CHECK_EQUAL(tfm::formatBraces("[{:6}|{:>6}]", std::string_view("ab"), std::string_view("ab")),
+                    "[ab    |    ab]");
+#       endif
+        std::ostringstream out;
+        out << std::hex;
+        out.width(3);
+        tfm::formatBraces(out, "{}", 10);
+        out << 10;
+        CHECK_EQUAL(out.str(), "10  a");
+        EXPECT_ERROR( tfm::formatBraces("{} {}", 1) )
+        EXPECT_ERROR( tfm::formatBraces("{2}", 1, 2) )
+        EXPECT_ERROR( tfm::formatBraces("{} {0}", 1) )
+        EXPECT_ERROR( tfm::formatBraces("{:5d", 1) )
+        EXPECT_ERROR( tfm::formatBraces("a } b", 1) )
+    }
+
+    // Test field-wise formatting of registered aggregates
+    {
+        testfields::Order order = { 7, "A\"B", 9.5, { 1, -2 } };
+        CHECK_EQUAL(tfm::format("%s", order),
+                    "{id=7, symbol=\"A\\\"B\", price=9.5, where={x=1, y=-2}}");
+        testfields::Point p = { 3, 40 };
+        CHECK_EQUAL(tfm::format("%d|%3d|%x", p, p, p), "{x=3, y=40}|{x=  3, y= 40}|{x=3, y=28}");
+        // The spec applies to every field; integers ignore the precision
+        CHECK_EQUAL(tfm::format("%.2f", order),
+                    "{id=7, symbol=\"A\\\"B\", price=9.50, where={x=1, y=-2}}");
+        CHECK_EQUAL(tfm::formatBraces("[{}]", p), "[{x=3, y=40}]");
+        testfields::Order longOrder = { 1, std::string(200, 'q'), 0, { 0, 0 } };
+        CHECK_EQUAL(tfm::format("%s", longOrder), "{id=1, symbol=\"" + std::string(200, 'q') +
+                    "\", price=0, where={x=0, y=0}}");
+    }
+
+    // Test fixed point decimals
+    {
+        CHECK_EQUAL(tfm::format("%s", tfm::decimal(12345, 2)), "123.45");
+        CHECK_EQUAL(tfm::format("%s", tfm::decimal(-5, 3)), "-0.005");
+        CHECK_EQUAL(tfm::format("%f", tfm::decimal(12345678901LL, 8)), "123.456789");
+        CHECK_EQUAL(tfm::format("%.4f", tfm::decimal(12345, 2)), "123.4500");
+        CHECK_EQUAL(tfm::format("%.1f|%.1f|%.1f", tfm::decimal(125, 2), tfm::decimal(135, 2),
+                                tfm::decimal(1251, 3)), "1.2|1.4|1.3");
+        CHECK_EQUAL(tfm::format("%.0f|%#.0f|%.0f", tfm::decimal(-25, 1), tfm::decimal(7, 0),
+                                tfm::decimal(999, 3)), "-2|7.|1");
+        CHECK_EQUAL(tfm::format("[%10.2f|%-9.1f|%010.2f|%+.2f|% .2f]", tfm::decimal(-314159, 5),
+                                tfm::decimal(5, 0), tfm::decimal(-314159, 5),
+                                tfm::decimal(1, 2), tfm::decimal(1, 2)),
+                    "[     -3.14|5.0      |-000003.14|+0.01| 0.01]");
+        CHECK_EQUAL(tfm::format("%.2f|%s", tfm::decimal(LLONG_MIN, 18), tfm::decimal(LLONG_MIN, 0)),
+                    "-9.22|-9223372036854775808");
+        CHECK_EQUAL(tfm::format("%.19f", tfm::decimal(LLONG_MAX, 19)), "0.9223372036854775807");
+        // 123.75 is exact in binary, so the result doesn't depend on the
+        // width of long double
+        CHECK_EQUAL(tfm::format("%.3s|%.3e|%.5g", tfm::decimal(12345, 2), tfm::decimal(12375, 2),
+                                tfm::decimal(-5, 1)), "123|1.238e+02|-0.5");
+        EXPECT_ERROR( tfm::format("%f", tfm::decimal(1, 20)) )
+    }
+
+#ifdef TINYFORMAT_HAS_SMART_POINTERS
+    // Test smart pointers
+    {
+        std::shared_ptr<int> sp(new int(42));
+        std::unique_ptr<std::string> up(new std::string("abc"));
+        std::unique_ptr<double> nullp;
+        CHECK_EQUAL(tfm::format("%d %5s %.1s|%s|%4s|", sp, *up, up, nullp, nullp), "42   abc a|none|none|");
+        CHECK_EQUAL(tfm::format("%x", sp), "2a");
+        CHECK_EQUAL(tfm::format("%p", sp), tfm::format("%p", static_cast<const void*>(sp.get())));
+        CHECK_EQUAL(tfm::format("%p", up), tfm::format("%p", static_cast<const void*>(up.get())));
+        std::shared_ptr<testfields::Point> pp(new testfields::Point());
+        pp->x = 1;
+        CHECK_EQUAL(tfm::format("%s", pp), "{x=1, y=0}");
+        // Pointers to void or to types which can't be formatted are
+        // formatted as the pointer
+        std::shared_ptr<void> vp(sp, sp.get());
+        std::string addr = tfm::format("%p", static_cast<const void*>(sp.get()));
+        CHECK_EQUAL(tfm::format("%p", vp), addr);
+        CHECK_EQUAL(tfm::format("%s", vp), addr);
+        std::shared_ptr<Opaque> op(new Opaque());
+        std::string opAddr = tfm::format("%p", static_cast<const void*>(op.get()));
+        CHECK_EQUAL(tfm::format("%p", op), opAddr);
+        CHECK_EQUAL(tfm::format("%s", op), opAddr);
+        // as are arrays, which are never dereferenced
+        std::unique_ptr<int[]> ap(new int[2]());
+        std::string arrAddr = tfm::format("%p", static_cast<const void*>(ap.get()));
+        CHECK_EQUAL(tfm::format("%p", ap), arrAddr);
+        CHECK_EQUAL(tfm::format("%d", ap), arrAddr);
+        CHECK_EQUAL(tfm::format("%p", std::unique_ptr<char[]>()),
+                    tfm::format("%p", static_cast<const void*>(0)));
+    }
+#endif
+
+#ifdef TINYFORMAT_HAS_OPTIONAL_VARIANT
+    // Test std::optional and std::variant
+    {
+        std::optional<int> some(255);
+        std::optional<int> none;
+        CHECK_EQUAL(tfm::format("%#x|%s|%-6s|", some, none, none), "0xff|none|none  |");
+        std::optional<std::shared_ptr<int>> nested(std::make_shared<int>(3));
+        std::shared_ptr<int[]> sharedArr(new int[2]());
+        CHECK_EQUAL(tfm::format("%s", sharedArr),
+                    tfm::format("%p", static_cast<const void*>(sharedArr.get())));
+        std::shared_ptr<int[4]> sharedFixed(new int[4]());
+        CHECK_EQUAL(tfm::format("%d", sharedFixed),
+                    tfm::format("%p", static_cast<const void*>(sharedFixed.get())));
+        CHECK_EQUAL(tfm::format("%03d", nested), "003");
+        std::variant<std::monostate, int, std::string, double> v;
+        CHECK_EQUAL(tfm::format("%s", v), "none");
+        v = 7;
+        CHECK_EQUAL(tfm::format("%+d", v), "+7");
+        v = std::string("text");
+        CHECK_EQUAL(tfm::format("%.2s", v), "te");
+        v = 0.25;
+        CHECK_EQUAL(tfm::format("%.3f", v), "0.250");
+        std::variant<std::optional<int>, char> vc('x');
+        CHECK_EQUAL(tfm::format("%c %d", vc, vc), "x 120");
+        vc = std::optional<int>(5);
+        CHECK_EQUAL(tfm::format("%s", vc), "5");
+    }
+#endif
+
     // Test that interface wrapping works correctly
     TestWrap wrap;
     CHECK_EQUAL(wrap.error(10, "someformat %s:%d:%d", "asdf", 2, 4),
@@ -251,6 +1272,7 @@ int unitTests()
     TestExceptionDef ex("blah %d", 100);
     CHECK_EQUAL(ex.what(), std::string("blah 100"));
 
+#ifndef TINYFORMAT_NO_HEAP
     // Test tfm::printf by swapping the std::cout stream buffer to capture data
     // which would noramlly go to the stdout
     std::ostringstream coutCapture;
@@ -259,6 +1281,7 @@ int unitTests()
     tfm::printfln("%s %s %d", "printfln", "test", "1");
     std::cout.rdbuf(coutBuf); // restore buffer
     CHECK_EQUAL(coutCapture.str(), "printf test 1\nprintfln test 1\n");
+#endif
 
     return nfailed;
 }